@@ -2,12 +2,34 @@
 #define SRC_ADVENTURE_H_
 
 #include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "../third_party/threadpool/threadpool.h"
 
+#include "anytime.h"
+#include "branch_and_bound.h"
+#include "choice_bits.h"
+#include "egg_partition.h"
+#include "frontier.h"
+#include "key_select.h"
+#include "knapsack.h"
+#include "meet_in_the_middle.h"
+#include "merge_sort.h"
+#include "numa.h"
+#include "packing_state.h"
+#include "partition.h"
+#include "preprocessing.h"
+#include "radix_sort.h"
+#include "sample_sort.h"
+#include "sharded.h"
+#include "sorting.h"
 #include "types.h"
 #include "utils.h"
+#include "weight_indexed.h"
 
 class Adventure {
  public:
@@ -15,6 +37,16 @@ class Adventure {
 
   virtual uint64_t packEggs(std::vector<Egg> eggs, BottomlessBag &bag) = 0;
 
+  // Packs every bag from the same eggs and returns the weight in each bag.
+  virtual std::vector<uint64_t> packEggsIntoBags(
+      std::vector<Egg> eggs, std::vector<BottomlessBag> &bags) {
+    std::vector<uint64_t> weights;
+    for (auto &bag : bags) {
+      weights.push_back(packEggs(eggs, bag));
+    }
+    return weights;
+  }
+
   virtual void arrangeSand(std::vector<GrainOfSand> &grains) = 0;
 
   virtual Crystal selectBestCrystal(std::vector<Crystal> &crystals) = 0;
@@ -25,40 +57,36 @@ class LonesomeAdventure : public Adventure {
   LonesomeAdventure() {}
 
   virtual uint64_t packEggs(std::vector<Egg> eggs, BottomlessBag &bag) {
-    int N = bag.getCapacity();
-
-    std::vector<uint64_t> DP(N + 1, 0);
-    std::vector<bool> possible(N + 1, false);
-    std::vector<std::pair<uint64_t, uint64_t>> retrieve(N + 1,
-                                                        std::make_pair(0, 0));
-    possible[0] = true;
-
-    for (auto &egg : eggs) {
-      int size = egg.getSize();
-      auto weight = egg.getWeight();
-      for (int i = N; i >= 0; --i) {
-        if (i >= size && possible[i - size]) {
-          if (DP[i - size] + weight > DP[i]) {
-            DP[i] = DP[i - size] + weight;
-            retrieve[i] = {size, weight};
-            possible[i] = true;
-          }
-        }
-      }
+    std::vector<PackItem> items = readItems(eggs);
+    if (prefersWeights(items, bag.getCapacity())) {
+      WeightSweeper sweeper(nullptr, 1);
+      return fillBag(
+          eggs, WeightIndexedPacker(sweeper).pack(items, bag.getCapacity()),
+          bag);
     }
-
-    for (int i = N; i >= 0; --i) {
-      if (possible[i]) {
-        int curr = i;
-        while (curr > 0) {
-          bag.addEgg(Egg(retrieve[curr].first, retrieve[curr].second));
-          curr -= retrieve[i].first;
-        }
-        return DP[i];
-      }
+    if (prefersFrontier(items, bag.getCapacity())) {
+      return fillBag(eggs,
+                     FrontierPacker(nullptr).pack(items, bag.getCapacity()),
+                     bag);
+    }
+    if (isSubsetSum(items)) {
+      BitsetSweeper sweeper(nullptr, 1);
+      return fillBag(eggs,
+                     SubsetSumPacker(sweeper).pack(items, bag.getCapacity()),
+                     bag);
     }
 
-    return 0;
+    switch (narrowestCell(items)) {
+      case CellWidth::Bits16:
+        return fillBag(eggs, packRows<uint16_t>(items, bag.getCapacity()),
+                       bag);
+      case CellWidth::Bits32:
+        return fillBag(eggs, packRows<uint32_t>(items, bag.getCapacity()),
+                       bag);
+      default:
+        return fillBag(eggs, packRows<uint64_t>(items, bag.getCapacity()),
+                       bag);
+    }
   }
 
   static void quick_sort(std::vector<GrainOfSand>::iterator first,
@@ -90,107 +118,451 @@ class LonesomeAdventure : public Adventure {
   virtual Crystal selectBestCrystal(std::vector<Crystal> &crystals) {
     return *std::max_element(crystals.begin(), crystals.end());
   }
+
+ private:
+  // Rows that do not fit in L2 are swept tile by tile.
+  template <class Cell>
+  static Packing packRows(std::vector<PackItem> const &items,
+                          uint64_t capacity) {
+    const uint64_t cachedRowBytes = 1 << 18;
+
+    SequentialSweeper<Cell> sequential;
+    TiledSweeper<Cell> tiled(nullptr, 1);
+    RowSweeper<Cell> &sweeper =
+        capacity < cachedRowBytes / sizeof(Cell)
+            ? static_cast<RowSweeper<Cell> &>(sequential)
+            : tiled;
+    return RollingRowPacker<Cell>(sweeper).pack(items, capacity);
+  }
 };
 
 class TeamAdventure : public Adventure {
  public:
-  explicit TeamAdventure(uint64_t numberOfShamansArg)
+  explicit TeamAdventure(
+      uint64_t numberOfShamansArg,
+      PackingEngine packingEngineArg = PackingEngine::Auto,
+      SweepSchedule sweepScheduleArg = SweepSchedule::Futures,
+      std::string const &choiceSpillDirectoryArg = std::string())
       : numberOfShamans(numberOfShamansArg),
-        councilOfShamans(numberOfShamansArg) {}
+        packingEngine(packingEngineArg),
+        sweepSchedule(sweepScheduleArg),
+        choiceSpillDirectory(choiceSpillDirectoryArg),
+        numaTopology(sweepScheduleArg == SweepSchedule::NumaLocal
+                         ? NumaTopology::detect()
+                         : NumaTopology(std::vector<std::vector<int>>())),
+        sortEngine(SortEngine::QuickSort),
+        crystalSelection(CrystalSelection::Comparisons),
+        councilOfShamans(numberOfShamansArg),
+        sandMergeSorter(councilOfShamans, numberOfShamansArg),
+        sandFrugalSorter(councilOfShamans, numberOfShamansArg, true),
+        sandSampleSorter(councilOfShamans, numberOfShamansArg),
+        sandRadixSorter(councilOfShamans, numberOfShamansArg),
+        crystalSelector(councilOfShamans, numberOfShamansArg) {}
+
+  TeamAdventure(uint64_t numberOfShamansArg, SortEngine sortEngineArg)
+      : TeamAdventure(numberOfShamansArg) {
+    sortEngine = sortEngineArg;
+  }
 
-  uint64_t packEggs(std::vector<Egg> eggs, BottomlessBag &bag) {
-    const uint64_t threshold = 20;
+  TeamAdventure(uint64_t numberOfShamansArg,
+                CrystalSelection crystalSelectionArg)
+      : TeamAdventure(numberOfShamansArg) {
+    crystalSelection = crystalSelectionArg;
+  }
 
+  uint64_t packEggs(std::vector<Egg> eggs, BottomlessBag &bag) {
+    sweepLoad = SweepLoad();
+    EggPreprocessor preprocessor(councilOfShamans, numberOfShamans);
     uint64_t N = bag.getCapacity();
-    uint64_t M = eggs.size();
+    std::vector<PackItem> items =
+        preprocessor.reduce(preprocessor.readItems(eggs), N, preprocessReport);
 
-    std::vector<std::vector<uint64_t>> DP(M + 1,
-                                          std::vector<uint64_t>(N + 1, 0));
-    std::vector<std::vector<bool>> possible(M + 1,
-                                            std::vector<bool>(N + 1, false));
-    std::vector<std::pair<uint64_t, uint64_t>> retrieve(N + 1,
-                                                        std::make_pair(0, 0));
+    return fillBag(eggs, preprocessor.expand(pack(items, N)), bag);
+  }
 
-    possible[0][0] = true;
+  // packEggs() that answers within about `budget`. A greedy packing and the
+  // fractional bound come first; the exact rolling-row DP then runs until
+  // the deadline, checked between blocks of eggs. The bag gets the best
+  // packing found in time. Bags whose rows do not fit in memory are packed
+  // by branch and bound, which keeps its best packing when time runs out.
+  AnytimePacking packEggsWithin(std::vector<Egg> eggs, BottomlessBag &bag,
+                                std::chrono::nanoseconds budget) {
+    Deadline deadline(std::chrono::steady_clock::now() + budget);
+    sweepLoad = SweepLoad();
+    EggPreprocessor preprocessor(councilOfShamans, numberOfShamans);
+    uint64_t N = bag.getCapacity();
+    std::vector<PackItem> items =
+        preprocessor.reduce(preprocessor.readItems(eggs), N, preprocessReport);
+
+    std::vector<size_t> order = densityOrder(items);
+    Packing packing = greedyPacking(items, order, N);
+    AnytimePacking result;
+    result.upperBound = fractionalBound(items, order, N);
+    if (packing.weight < result.upperBound && rowsFit(items, N)) {
+      try {
+        switch (narrowestCell(items)) {
+          case CellWidth::Bits16:
+            packing = packRowsWithin<uint16_t>(items, N, deadline);
+            break;
+          case CellWidth::Bits32:
+            packing = packRowsWithin<uint32_t>(items, N, deadline);
+            break;
+          default:
+            packing = packRowsWithin<uint64_t>(items, N, deadline);
+            break;
+        }
+        result.upperBound = packing.weight;
+      } catch (DeadlineExceeded const &) {
+      }
+    } else if (packing.weight < result.upperBound) {
+      BranchAndBoundPacker packer(councilOfShamans, numberOfShamans, deadline);
+      packing = packer.pack(items, N);
+      if (packer.finished()) {
+        result.upperBound = packing.weight;
+      }
+    }
 
-    for (size_t i = 1; i <= M; i++) {
-      uint64_t size = eggs[i - 1].getSize();
-      uint64_t weight = eggs[i - 1].getWeight();
+    result.weight = fillBag(eggs, preprocessor.expand(packing), bag);
+    return result;
+  }
 
-      uint64_t interval = std::max(N / numberOfShamans + 1, threshold);
+  // One DP up to the largest capacity recording ChoiceBits, then the eggs
+  // of every bag are recovered in parallel. When the bits would not fit,
+  // every bag is packed on its own.
+  virtual std::vector<uint64_t> packEggsIntoBags(
+      std::vector<Egg> eggs, std::vector<BottomlessBag> &bags) {
+    const uint64_t choiceBitsBudget = 1ULL << 30;
+    const uint64_t spilledChoiceBitsBudget = 1ULL << 36;
+
+    sweepLoad = SweepLoad();
+    EggPreprocessor preprocessor(councilOfShamans, numberOfShamans);
+    uint64_t N = 0;
+    for (auto &bag : bags) {
+      N = std::max(N, bag.getCapacity());
+    }
+    std::vector<PackItem> items =
+        preprocessor.reduce(preprocessor.readItems(eggs), N, preprocessReport);
+    N = std::min(N, totalSize(items));
+
+    std::vector<Packing> packings(bags.size());
+    if (!rowsFit(items, N) ||
+        ChoiceBits::bytesFor(items.size(), N) >
+            (choiceSpillDirectory.empty() ? choiceBitsBudget
+                                          : spilledChoiceBitsBudget)) {
+      for (size_t b = 0; b < bags.size(); b++) {
+        packings[b] =
+            pack(items, bags[b].getCapacity() / preprocessReport.scale);
+      }
+    } else {
+      ChoiceBits choices(items.size(), N, choiceSpillDirectory);
+      recordChoices(items, N, choices);
 
+      uint64_t interval = bags.size() / numberOfShamans + 1;
+      uint64_t scale = preprocessReport.scale;
       std::vector<std::future<void>> results;
-      for (size_t first = 0; first <= N; first += interval) {
+      for (uint64_t lo = 0; lo < bags.size(); lo += interval) {
+        uint64_t hi = std::min<uint64_t>(bags.size(), lo + interval);
         results.emplace_back(councilOfShamans.enqueue(
-            [first, &DP, N, size, weight, &possible, &retrieve, interval, i] {
-              for (size_t j = first; j <= std::min(N, first + interval - 1);
-                   j++) {
-                if (possible[i - 1][j]) {
-                  DP[i][j] = DP[i - 1][j];
-                  possible[i][j] = true;
-                }
-
-                if (j >= size && possible[i - 1][j - size]) {
-                  possible[i][j] = true;
-                  if (DP[i][j] < DP[i - 1][j - size] + weight) {
-                    DP[i][j] = DP[i - 1][j - size] + weight;
-                    retrieve[j] = {size, weight};
-                  }
-                }
+            [lo, hi, N, scale, &items, &bags, &choices, &packings] {
+              for (uint64_t b = lo; b < hi; b++) {
+                packings[b] = choices.recover(
+                    items, std::min(N, bags[b].getCapacity() / scale));
               }
             }));
       }
-
       for (auto &&result : results) {
         result.get();
       }
     }
 
-    for (int i = N; i >= 0; --i) {
-      if (possible[M][i]) {
-        int curr = i;
-        while (curr > 0) {
-          bag.addEgg(Egg(retrieve[curr].first, retrieve[curr].second));
-          curr -= retrieve[i].first;
-        }
-        return DP[M][i];
+    std::vector<uint64_t> weights;
+    for (size_t b = 0; b < bags.size(); b++) {
+      weights.push_back(
+          fillBag(eggs, preprocessor.expand(packings[b]), bags[b]));
+    }
+    return weights;
+  }
+
+  // A live DP for eggs that arrive over time, swept by the shamans. The
+  // state borrows the council, so it has to go before the adventure does.
+  std::unique_ptr<EggPackingState> makePackingState(uint64_t capacity) {
+    return std::unique_ptr<EggPackingState>(
+        new EggPackingState(capacity, makeSweeper<uint64_t>()));
+  }
+
+  // What preprocessing removed during the last packEggs().
+  PreprocessReport getPreprocessReport() const { return preprocessReport; }
+
+  // Busy and idle time per stripe of the threaded sweeps of the last
+  // packEggs(), to check how evenly the shamans share each row.
+  SweepLoad getSweepLoad() const { return sweepLoad; }
+
+ private:
+  Packing pack(std::vector<PackItem> const &items, uint64_t N) {
+    switch (selectEngine(items, N)) {
+      case PackingEngine::Table:
+        return packTable(items, N);
+      case PackingEngine::Frontier:
+        return FrontierPacker(&councilOfShamans).pack(items, N);
+      case PackingEngine::MeetInTheMiddle: {
+        MeetInTheMiddlePacker packer(
+            councilOfShamans, numberOfShamans,
+            [this](MeetInTheMiddlePacker::Iterator first,
+                   MeetInTheMiddlePacker::Iterator last) {
+              quick_sort(first, last, (last - first) / numberOfShamans + 1);
+            });
+        return packer.pack(items, N);
+      }
+      case PackingEngine::WeightIndexed: {
+        WeightSweeper sweeper(&councilOfShamans, numberOfShamans);
+        return WeightIndexedPacker(sweeper).pack(items, N);
+      }
+      case PackingEngine::EggPartition:
+        return EggPartitionPacker(councilOfShamans, numberOfShamans)
+            .pack(items, N);
+      case PackingEngine::BranchAndBound:
+        return BranchAndBoundPacker(councilOfShamans, numberOfShamans)
+            .pack(items, N);
+      case PackingEngine::SubsetSum: {
+        BitsetSweeper sweeper(&councilOfShamans, numberOfShamans);
+        return SubsetSumPacker(sweeper).pack(items, N);
       }
+      default:
+        switch (narrowestCell(items)) {
+          case CellWidth::Bits16:
+            return packRows<uint16_t>(items, N);
+          case CellWidth::Bits32:
+            return packRows<uint32_t>(items, N);
+          default:
+            return packRows<uint64_t>(items, N);
+        }
     }
+  }
 
-    return 0;
+  template <class Cell>
+  Packing packRows(std::vector<PackItem> const &items, uint64_t N) {
+    std::unique_ptr<RowSweeper<Cell>> sweeper = makeSweeper<Cell>();
+    return RollingRowPacker<Cell>(*sweeper).pack(items, N);
+  }
+
+  // An engine that cannot handle the input falls back to the automatic
+  // choice.
+  PackingEngine selectEngine(std::vector<PackItem> const &items, uint64_t N) {
+    const uint64_t tableCellBudget = 1 << 22;
+    const uint64_t mergeRowCells = 1 << 13;
+    const uint64_t weightCellBudget = 1 << 28;
+
+    bool subsetSum = isSubsetSum(items);
+    size_t usefulEggs = MeetInTheMiddlePacker::usefulEggs(items, N).size();
+    switch (packingEngine) {
+      case PackingEngine::Auto:
+        break;
+      case PackingEngine::Frontier:
+      case PackingEngine::BranchAndBound:
+        return packingEngine;
+      case PackingEngine::MeetInTheMiddle:
+        if (usefulEggs <= MeetInTheMiddlePacker::maxEggs) {
+          return packingEngine;
+        }
+        break;
+      case PackingEngine::WeightIndexed:
+        if (weightsFit(items) &&
+            items.size() * totalWeight(items, 0, items.size()) <=
+                weightCellBudget) {
+          return packingEngine;
+        }
+        break;
+      case PackingEngine::EggPartition:
+        if (N < mergeRowCells) {
+          return packingEngine;
+        }
+        break;
+      case PackingEngine::SubsetSum:
+        if (subsetSum && rowsFit(items, N)) {
+          return packingEngine;
+        }
+        break;
+      default:
+        if (rowsFit(items, N)) {
+          return packingEngine;
+        }
+        break;
+    }
+
+    if (prefersWeights(items, N)) {
+      return PackingEngine::WeightIndexed;
+    }
+    // A frontier can reach 2^M points, while meet-in-the-middle is bounded
+    // by 2^(M/2); without rows to fall back on, take the safe bound.
+    if (!rowsFit(items, N) && usefulEggs <= MeetInTheMiddlePacker::maxEggs) {
+      return PackingEngine::MeetInTheMiddle;
+    }
+    // Past that, both a frontier and the search tree can blow up. The
+    // fractional bound cuts the tree as soon as densities differ, so it
+    // usually stays tiny; when every egg has the same density the bound
+    // cuts nothing and only the frontier's merging of equal sizes helps.
+    if (!rowsFit(items, N) && !subsetSum) {
+      return PackingEngine::BranchAndBound;
+    }
+    if (prefersFrontier(items, N)) {
+      return PackingEngine::Frontier;
+    }
+    if (subsetSum) {
+      return PackingEngine::SubsetSum;
+    }
+    if (EggPartitionPacker::pays(items, N, numberOfShamans)) {
+      return PackingEngine::EggPartition;
+    }
+    return (items.size() + 1) * (N + 1) <= tableCellBudget
+               ? PackingEngine::Table
+               : PackingEngine::RollingRows;
+  }
+
+  template <class Cell>
+  Packing packRowsWithin(std::vector<PackItem> const &items, uint64_t N,
+                         Deadline deadline) {
+    std::unique_ptr<RowSweeper<Cell>> sweeper = makeSweeper<Cell>();
+    DeadlineSweeper<Cell> timed(*sweeper, deadline);
+    return RollingRowPacker<Cell>(timed).pack(items, N);
+  }
+
+  template <class Cell>
+  std::unique_ptr<RowSweeper<Cell>> makeSweeper() {
+    if (sweepSchedule == SweepSchedule::Wavefront) {
+      return std::unique_ptr<RowSweeper<Cell>>(
+          new TiledSweeper<Cell>(&councilOfShamans, numberOfShamans));
+    }
+    if (sweepSchedule == SweepSchedule::NumaLocal) {
+      return std::unique_ptr<RowSweeper<Cell>>(new NumaSweeper<Cell>(
+          councilOfShamans, numberOfShamans, numaTopology, &sweepLoad));
+    }
+    if (sweepSchedule == SweepSchedule::Processes) {
+      return std::unique_ptr<RowSweeper<Cell>>(
+          new ShardedSweeper<Cell>(numberOfShamans));
+    }
+    if (sweepSchedule == SweepSchedule::Barrier) {
+      return std::unique_ptr<RowSweeper<Cell>>(
+          new BarrierSweeper<Cell>(councilOfShamans, numberOfShamans,
+                                   &sweepLoad));
+    }
+    return std::unique_ptr<RowSweeper<Cell>>(
+        new StripedSweeper<Cell>(councilOfShamans, numberOfShamans,
+                                 &sweepLoad));
+  }
+
+  // One sweep with two rolling rows that records a taken bit per (egg,
+  // capacity) instead of keeping every row; the eggs are read back from the
+  // bits with one lookup per egg.
+  Packing packTable(std::vector<PackItem> const &items, uint64_t N) {
+    ChoiceBits choices(items.size(), N, choiceSpillDirectory);
+    recordChoices(items, N, choices);
+    return choices.recover(items, N);
+  }
+
+  // The whole DP up to N in cells as narrow as the eggs allow.
+  void recordChoices(std::vector<PackItem> const &items, uint64_t N,
+                     ChoiceBits &choices) {
+    switch (narrowestCell(items)) {
+      case CellWidth::Bits16:
+        return recordChoices<uint16_t>(items, N, choices);
+      case CellWidth::Bits32:
+        return recordChoices<uint32_t>(items, N, choices);
+      default:
+        return recordChoices<uint64_t>(items, N, choices);
+    }
+  }
+
+  template <class Cell>
+  void recordChoices(std::vector<PackItem> const &items, uint64_t N,
+                     ChoiceBits &choices) {
+    std::vector<Cell> row(N + 1);
+    ChoiceSweeper<Cell>(councilOfShamans, numberOfShamans, &sweepLoad)
+        .sweep(items, row, choices);
   }
 
  public:
-  void quick_sort(std::vector<GrainOfSand>::iterator first,
-                  std::vector<GrainOfSand>::iterator last, int threshold) {
+  // Ranges above `threshold` are split level by level, every split a
+  // parallelPartition() around a sampled pivot with all shamans; the ranges
+  // left are then sorted by one shaman each. When nothing is less than the
+  // pivot, the elements equal to it are split off instead; they need no
+  // more sorting.
+  template <class Iterator>
+  void quick_sort(Iterator first, Iterator last, int threshold) {
+    typedef typename std::iterator_traits<Iterator>::value_type Value;
+    const int64_t minChunk = 256;
+
     if (last - first <= threshold) {
       std::sort(first, last);
       return;
     }
 
-    std::vector<GrainOfSand>::iterator mid = first + (last - first) / 2;
-    std::nth_element(first, mid, last);
-    auto r = last - 1;
-    for (auto it = first; it < mid; it++) {
-      if (*mid < *it) {
-        while (r > mid && *mid < *r) {
-          r--;
+    std::vector<std::pair<Iterator, Iterator>> level{{first, last}}, leaves;
+    while (!level.empty()) {
+      std::vector<std::pair<Iterator, Iterator>> next;
+      for (auto range : level) {
+        if (range.second - range.first <= threshold) {
+          leaves.push_back(range);
+          continue;
+        }
+        uint64_t chunks = std::min<uint64_t>(
+            numberOfShamans, (range.second - range.first) / minChunk + 1);
+        Value pivot =
+            samplePivot(councilOfShamans, chunks, range.first, range.second);
+        Iterator mid = parallelPartition(
+            councilOfShamans, chunks, range.first, range.second,
+            [pivot](Value const &value) { return value < pivot; });
+        if (mid == range.first) {
+          next.emplace_back(
+              parallelPartition(
+                  councilOfShamans, chunks, range.first, range.second,
+                  [pivot](Value const &value) { return !(pivot < value); }),
+              range.second);
+        } else {
+          next.emplace_back(range.first, mid);
+          next.emplace_back(mid, range.second);
         }
-        std::iter_swap(it, r);
       }
+      level.swap(next);
+    }
+
+    std::vector<std::future<void>> results;
+    for (auto range : leaves) {
+      results.emplace_back(councilOfShamans.enqueue(
+          [range] { std::sort(range.first, range.second); }));
+    }
+    for (auto &&result : results) {
+      result.get();
     }
-    auto f = councilOfShamans.enqueue(
-        [first, mid, threshold, this] { quick_sort(first, mid, threshold); });
-    quick_sort(mid, last, threshold);
-    f.get();
   }
 
   virtual void arrangeSand(std::vector<GrainOfSand> &grains) {
-    auto first = grains.begin(), last = grains.end();
-    quick_sort(first, last, (last - first) / numberOfShamans + 1);
+    switch (sortEngine) {
+      case SortEngine::MergeSort:
+        sandMergeSorter.sort(grains, false);
+        break;
+      case SortEngine::StableMergeSort:
+        sandMergeSorter.sort(grains, true);
+        break;
+      case SortEngine::FrugalMergeSort:
+        sandFrugalSorter.sort(grains, true);
+        break;
+      case SortEngine::SampleSort:
+        sandSampleSorter.sort(grains);
+        break;
+      case SortEngine::RadixSort:
+        sandRadixSorter.sort(grains);
+        break;
+      default:
+        auto first = grains.begin(), last = grains.end();
+        quick_sort(first, last, (last - first) / numberOfShamans + 1);
+        break;
+    }
   }
 
   virtual Crystal selectBestCrystal(std::vector<Crystal> &crystals) {
+    if (crystalSelection == CrystalSelection::Keys) {
+      return crystalSelector.max(crystals);
+    }
     Crystal result;
     std::vector<std::future<Crystal>> results;
 
@@ -225,7 +597,23 @@ class TeamAdventure : public Adventure {
 
  private:
   uint64_t numberOfShamans;
+  PackingEngine packingEngine;
+  SweepSchedule sweepSchedule;
+  // Where ChoiceBits are spilled to a mapped file; empty keeps them in
+  // memory.
+  std::string choiceSpillDirectory;
+  // Detected once, and only for SweepSchedule::NumaLocal.
+  NumaTopology numaTopology;
+  SortEngine sortEngine;
+  CrystalSelection crystalSelection;
+  PreprocessReport preprocessReport;
+  SweepLoad sweepLoad;
   ThreadPool councilOfShamans;
+  MergeSorter<GrainOfSand> sandMergeSorter;
+  MergeSorter<GrainOfSand> sandFrugalSorter;
+  SampleSorter<GrainOfSand> sandSampleSorter;
+  RadixSorter<GrainOfSand> sandRadixSorter;
+  KeySelector<Crystal> crystalSelector;
 };
 
 #endif  // SRC_ADVENTURE_H_
@@ -0,0 +1,131 @@
+#ifndef SRC_ANYTIME_H_
+#define SRC_ANYTIME_H_
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include "knapsack.h"
+
+// Result of a packing under a deadline: the weight in the bag and a proven
+// upper bound of the best weight. They are equal when the packing is
+// optimal.
+struct AnytimePacking {
+  AnytimePacking() : weight(0), upperBound(0) {}
+
+  bool exact() const { return weight == upperBound; }
+
+  uint64_t weight;
+  uint64_t upperBound;
+};
+
+class Deadline {
+ public:
+  explicit Deadline(std::chrono::steady_clock::time_point atArg) : at(atArg) {}
+
+  static Deadline never() {
+    return Deadline(std::chrono::steady_clock::time_point::max());
+  }
+
+  bool expired() const { return std::chrono::steady_clock::now() >= at; }
+
+ private:
+  std::chrono::steady_clock::time_point at;
+};
+
+struct DeadlineExceeded : public std::runtime_error {
+  DeadlineExceeded() : std::runtime_error("knapsack deadline exceeded") {}
+};
+
+// Eggs by decreasing weight per size; eggs without size come first and eggs
+// without weight last. Weightless eggs must be kept apart: an egg that is
+// empty in both would tie with every other one, which std::sort does not
+// allow.
+std::vector<size_t> densityOrder(std::vector<PackItem> const &items) {
+  std::vector<size_t> order(items.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&items](size_t a, size_t b) {
+    if ((items[a].weight == 0) != (items[b].weight == 0)) {
+      return items[b].weight == 0;
+    }
+    return static_cast<unsigned __int128>(items[a].weight) * items[b].size >
+           static_cast<unsigned __int128>(items[b].weight) * items[a].size;
+  });
+  return order;
+}
+
+// Greedy packing in density order, or the heaviest single egg when that is
+// better; at least half of the optimum.
+Packing greedyPacking(std::vector<PackItem> const &items,
+                      std::vector<size_t> const &order, uint64_t capacity) {
+  Packing packing, single;
+  uint64_t room = capacity;
+  for (auto index : order) {
+    PackItem const &item = items[index];
+    if (item.size > capacity || item.weight == 0) {
+      continue;
+    }
+    if (item.size <= room) {
+      room -= item.size;
+      packing.weight += item.weight;
+      packing.chosen.push_back(index);
+    }
+    if (item.weight > single.weight) {
+      single.weight = item.weight;
+      single.chosen.assign(1, index);
+    }
+  }
+  Packing &best = single.weight > packing.weight ? single : packing;
+  std::sort(best.chosen.begin(), best.chosen.end());
+  return best;
+}
+
+// Optimum of the fractional knapsack, which bounds the 0/1 optimum: eggs in
+// density order until the first that does not fit, plus the fitting share
+// of that one.
+uint64_t fractionalBound(std::vector<PackItem> const &items,
+                         std::vector<size_t> const &order, uint64_t capacity) {
+  uint64_t bound = 0, room = capacity;
+  for (auto index : order) {
+    PackItem const &item = items[index];
+    if (item.size > room) {
+      return bound + static_cast<uint64_t>(
+                         static_cast<unsigned __int128>(item.weight) * room /
+                         item.size);
+    }
+    room -= item.size;
+    bound += item.weight;
+  }
+  return bound;
+}
+
+// Runs another sweeper in blocks of eggs and throws DeadlineExceeded
+// between blocks once the deadline has passed. Checks run on the calling
+// thread only, so no shaman is left behind.
+template <class Cell>
+class DeadlineSweeper : public RowSweeper<Cell> {
+ public:
+  DeadlineSweeper(RowSweeper<Cell> &sweeperArg, Deadline deadlineArg)
+      : sweeper(sweeperArg), deadline(deadlineArg) {}
+
+  virtual void extend(std::vector<PackItem> const &items, size_t first,
+                      size_t last, std::vector<Cell> &row) {
+    const size_t eggsPerCheck = 16;
+
+    for (size_t block = first; block < last; block += eggsPerCheck) {
+      if (deadline.expired()) {
+        throw DeadlineExceeded();
+      }
+      sweeper.extend(items, block, std::min(last, block + eggsPerCheck), row);
+    }
+  }
+
+ private:
+  RowSweeper<Cell> &sweeper;
+  Deadline deadline;
+};
+
+#endif  // SRC_ANYTIME_H_
@@ -0,0 +1,256 @@
+#ifndef SRC_BRANCH_AND_BOUND_H_
+#define SRC_BRANCH_AND_BOUND_H_
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "anytime.h"
+#include "knapsack.h"
+
+// Exact knapsack by depth-first branch and bound over eggs in density order,
+// for a capacity too big for rows and too many eggs for meet-in-the-middle.
+// A subtree is cut when its fractional bound cannot beat the best packing
+// found by any shaman, which they share through an atomic.
+//
+// Every shaman owns a deque of subtrees. While its deque is short it hands
+// out the "skip this egg" branch of the node it explores instead of
+// exploring it; idle shamans steal the oldest, biggest subtrees from the
+// others. A Deadline stops the search with the best packing found so far.
+class BranchAndBoundPacker {
+ public:
+  BranchAndBoundPacker(ThreadPool &councilArg, uint64_t numberOfShamansArg,
+                       Deadline deadlineArg = Deadline::never())
+      : council(councilArg),
+        numberOfShamans(numberOfShamansArg),
+        deadline(deadlineArg),
+        stopped(false) {}
+
+  Packing pack(std::vector<PackItem> const &items, uint64_t capacity) {
+    eggs.clear();
+    for (auto index : densityOrder(items)) {
+      if (items[index].size <= capacity && items[index].weight > 0) {
+        eggs.push_back(index);
+      }
+    }
+    size.clear();
+    weight.clear();
+    prefixSize.assign(1, 0);
+    prefixWeight.assign(1, 0);
+    for (auto index : eggs) {
+      size.push_back(items[index].size);
+      weight.push_back(items[index].weight);
+      prefixSize.push_back(prefixSize.back() + items[index].size);
+      prefixWeight.push_back(prefixWeight.back() + items[index].weight);
+    }
+    minSize.assign(eggs.size() + 1, UINT64_MAX);
+    for (size_t e = eggs.size(); e-- > 0;) {
+      minSize[e] = std::min(minSize[e + 1], size[e]);
+    }
+
+    Packing greedy = greedyPacking(items, densityOrder(items), capacity);
+    incumbent.store(greedy.weight);
+    stopped.store(false);
+    outstanding.store(1);
+    workers.clear();
+    for (uint64_t w = 0; w < numberOfShamans; w++) {
+      workers.emplace_back(new Worker());
+    }
+    Node root = {0, capacity, 0, std::vector<uint64_t>(eggs.size() / 64 + 1)};
+    workers[0]->nodes.push_back(root);
+    workers[0]->queued.store(1);
+
+    std::vector<std::future<void>> results;
+    for (uint64_t w = 0; w < numberOfShamans; w++) {
+      results.emplace_back(council.enqueue([this, w] { work(w); }));
+    }
+    for (auto &&result : results) {
+      result.get();
+    }
+
+    Worker const *best = nullptr;
+    for (auto &worker : workers) {
+      if (worker->bestWeight > greedy.weight &&
+          (best == nullptr || worker->bestWeight > best->bestWeight)) {
+        best = worker.get();
+      }
+    }
+    if (best == nullptr) {
+      return greedy;
+    }
+    Packing packing;
+    packing.weight = best->bestWeight;
+    for (size_t e = 0; e < eggs.size(); e++) {
+      if ((best->bestTaken[e / 64] >> (e % 64)) & 1) {
+        packing.chosen.push_back(eggs[e]);
+      }
+    }
+    std::sort(packing.chosen.begin(), packing.chosen.end());
+    return packing;
+  }
+
+  // False when the deadline stopped the last pack() before it was done.
+  bool finished() const { return !stopped.load(); }
+
+ private:
+  // Eggs [0, depth) are decided, the ones set in `taken` are packed.
+  struct Node {
+    size_t depth;
+    uint64_t room;
+    uint64_t weight;
+    std::vector<uint64_t> taken;
+  };
+
+  struct Worker {
+    Worker() : queued(0), bestWeight(0) {}
+
+    std::mutex mutex;
+    std::deque<Node> nodes;
+    std::atomic<size_t> queued;
+    uint64_t bestWeight;
+    std::vector<uint64_t> bestTaken;
+  };
+
+  void work(uint64_t w) {
+    Node node;
+    while (outstanding.load() > 0 && !stopped.load()) {
+      if (!takeNode(w, node)) {
+        std::this_thread::yield();
+        continue;
+      }
+      explore(w, node);
+      outstanding.fetch_sub(1);
+    }
+  }
+
+  // The newest node of the shaman's own deque, or the oldest of another's.
+  bool takeNode(uint64_t w, Node &node) {
+    for (uint64_t k = 0; k < workers.size(); k++) {
+      Worker &victim = *workers[(w + k) % workers.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (victim.nodes.empty()) {
+        continue;
+      }
+      if (k == 0) {
+        node = std::move(victim.nodes.back());
+        victim.nodes.pop_back();
+      } else {
+        node = std::move(victim.nodes.front());
+        victim.nodes.pop_front();
+      }
+      victim.queued.fetch_sub(1);
+      return true;
+    }
+    return false;
+  }
+
+  // Depth first from `node`, taking eggs before leaving them out. The path
+  // is kept in `pending` instead of on the call stack, which a deep search
+  // over many eggs would overflow: it holds the eggs taken on the way down
+  // whose "leave out" branch is still to come.
+  void explore(uint64_t w, Node &node) {
+    const uint64_t nodesPerDeadlineCheck = 1 << 12;
+    const size_t sharedNodes = 2;
+    const size_t minSharedEggs = 8;
+
+    Worker &worker = *workers[w];
+    size_t depth = node.depth;
+    uint64_t room = node.room, packed = node.weight, visited = 0;
+    std::vector<uint64_t> &taken = node.taken;
+    std::vector<size_t> pending;
+    bool descend = true;
+    while (true) {
+      if (++visited % nodesPerDeadlineCheck == 0 && deadline.expired()) {
+        stopped.store(true);
+      }
+      if (stopped.load()) {
+        return;
+      }
+      if (descend && promising(worker, depth, room, packed, taken)) {
+        if (size[depth] > room) {
+          depth++;
+          continue;
+        }
+        taken[depth / 64] |= 1ULL << (depth % 64);
+        room -= size[depth];
+        packed += weight[depth];
+        pending.push_back(depth++);
+        continue;
+      } else {
+        if (pending.empty()) {
+          return;
+        }
+        depth = pending.back();
+        pending.pop_back();
+        taken[depth / 64] &= ~(1ULL << (depth % 64));
+        room += size[depth];
+        packed -= weight[depth];
+      }
+
+      // Egg `depth` is left out.
+      if (worker.queued.load() < sharedNodes &&
+          eggs.size() - depth > minSharedEggs) {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        outstanding.fetch_add(1);
+        worker.nodes.push_back({depth + 1, room, packed, taken});
+        worker.queued.fetch_add(1);
+        descend = false;
+      } else {
+        depth++;
+        descend = true;
+      }
+    }
+  }
+
+  // Records the packing of a node and tells whether its subtree can still
+  // beat the best one found; it cannot once none of its eggs fit.
+  bool promising(Worker &worker, size_t depth, uint64_t room, uint64_t packed,
+                 std::vector<uint64_t> const &taken) {
+    uint64_t best = incumbent.load();
+    while (packed > best && !incumbent.compare_exchange_weak(best, packed)) {
+    }
+    if (packed > worker.bestWeight) {
+      worker.bestWeight = packed;
+      worker.bestTaken = taken;
+    }
+    return room >= minSize[depth] &&
+           bound(depth, room) > incumbent.load() - packed;
+  }
+
+  // Fractional knapsack of eggs [depth, M) in `room`, from prefix sums.
+  uint64_t bound(size_t depth, uint64_t room) const {
+    unsigned __int128 limit = prefixSize[depth] + room;
+    size_t k = std::upper_bound(prefixSize.begin() + depth, prefixSize.end(),
+                                limit) -
+               prefixSize.begin() - 1;
+    unsigned __int128 total = prefixWeight[k] - prefixWeight[depth];
+    if (k < eggs.size()) {
+      total += static_cast<unsigned __int128>(weight[k]) *
+               static_cast<uint64_t>(limit - prefixSize[k]) / size[k];
+    }
+    return total > UINT64_MAX ? UINT64_MAX : static_cast<uint64_t>(total);
+  }
+
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+  Deadline deadline;
+
+  // Useful eggs in density order, with their sizes, weights, prefix sums
+  // of both and the smallest size from every egg on.
+  std::vector<size_t> eggs;
+  std::vector<uint64_t> size, weight, minSize;
+  std::vector<unsigned __int128> prefixSize, prefixWeight;
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::atomic<uint64_t> incumbent;
+  std::atomic<int64_t> outstanding;
+  std::atomic<bool> stopped;
+};
+
+#endif  // SRC_BRANCH_AND_BOUND_H_
@@ -0,0 +1,177 @@
+#ifndef SRC_CHOICE_BITS_H_
+#define SRC_CHOICE_BITS_H_
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "knapsack.h"
+
+// One "taken" bit per (egg, capacity): bit c of row i is set when the best
+// packing of eggs [0, i] into capacity c holds egg i. Rows are padded to
+// whole words, so stripes of 64 capacities never share a word.
+//
+// Given a directory, the bits live in an unlinked file there that is
+// mapped into memory, so the page cache can write them out instead of
+// them taking up memory.
+class ChoiceBits {
+ public:
+  ChoiceBits(uint64_t eggsArg, uint64_t capacityArg,
+             std::string const &spillDirectory = std::string())
+      : wordsPerRow(capacityArg / 64 + 1),
+        mappedBytes(0),
+        bits(nullptr) {
+    uint64_t words = eggsArg * wordsPerRow;
+    if (spillDirectory.empty()) {
+      memory.assign(words, 0);
+      bits = memory.data();
+      return;
+    }
+    std::string path = spillDirectory + "/choice-bits-XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+      throw std::runtime_error("cannot create choice bits file");
+    }
+    unlink(path.c_str());
+    mappedBytes = std::max<uint64_t>(words, 1) * 8;
+    void *mapping = MAP_FAILED;
+    if (ftruncate(fd, mappedBytes) == 0) {
+      mapping = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED) {
+      throw std::runtime_error("cannot map choice bits file");
+    }
+    bits = static_cast<uint64_t *>(mapping);
+  }
+
+  ~ChoiceBits() {
+    if (mappedBytes > 0) {
+      munmap(bits, mappedBytes);
+    }
+  }
+
+  ChoiceBits(ChoiceBits const &) = delete;
+  ChoiceBits &operator=(ChoiceBits const &) = delete;
+
+  static uint64_t bytesFor(uint64_t eggs, uint64_t capacity) {
+    return eggs * (capacity / 64 + 1) * 8;
+  }
+
+  uint64_t *row(uint64_t egg) { return bits + egg * wordsPerRow; }
+
+  bool taken(uint64_t egg, uint64_t c) const {
+    return (bits[egg * wordsPerRow + c / 64] >> (c % 64)) & 1;
+  }
+
+  // Walks the bits back from `capacity` and lists the chosen eggs, one bit
+  // per egg.
+  Packing recover(std::vector<PackItem> const &items,
+                  uint64_t capacity) const {
+    Packing packing;
+    for (uint64_t i = items.size(); i-- > 0;) {
+      if (taken(i, capacity)) {
+        packing.weight += items[i].weight;
+        packing.chosen.push_back(i);
+        capacity -= items[i].size;
+      }
+    }
+    std::reverse(packing.chosen.begin(), packing.chosen.end());
+    return packing;
+  }
+
+ private:
+  uint64_t wordsPerRow;
+  uint64_t mappedBytes;
+  std::vector<uint64_t> memory;
+  uint64_t *bits;
+};
+
+// Runs the whole DP once up to `capacity` and records ChoiceBits on the
+// way, so that the packing for every capacity up to it can be recovered
+// without another sweep. Stripes are cut by balancedBound() and rounded to
+// multiples of 64 capacities; every shaman gets the bits of a word from the
+// comparisons of relaxTaken() and stores the word once.
+template <class Cell>
+class ChoiceSweeper {
+ public:
+  ChoiceSweeper(ThreadPool &councilArg, uint64_t numberOfShamansArg,
+                SweepLoad *loadArg = nullptr)
+      : council(councilArg),
+        numberOfShamans(numberOfShamansArg),
+        load(loadArg) {}
+
+  void sweep(std::vector<PackItem> const &items, std::vector<Cell> &row,
+             ChoiceBits &choices) {
+    const uint64_t threshold = 1024;
+
+    uint64_t N = row.size();
+    uint64_t interval = std::max(N / numberOfShamans + 1, threshold);
+    uint64_t stripes = N / interval + 1;
+
+    std::fill(row.begin(), row.end(), 0);
+    std::vector<Cell> next(N);
+    std::vector<uint64_t> busy(stripes);
+
+    for (size_t i = 0; i < items.size(); i++) {
+      uint64_t size = items[i].size, weight = items[i].weight;
+      uint64_t *taken = choices.row(i);
+
+      std::vector<std::future<uint64_t>> results;
+      for (uint64_t s = 0; s < stripes; s++) {
+        uint64_t lo = balancedBound(N, size, stripes, s) / 64 * 64;
+        uint64_t hi = s + 1 == stripes
+                          ? N
+                          : balancedBound(N, size, stripes, s + 1) / 64 * 64;
+        results.emplace_back(
+            council.enqueue([lo, hi, size, weight, taken, &row, &next] {
+              auto start = std::chrono::steady_clock::now();
+              relaxStripe(row.data(), next.data(), taken, lo, hi, size,
+                          weight);
+              return nanosSince(start);
+            }));
+      }
+
+      for (uint64_t s = 0; s < stripes; s++) {
+        busy[s] = results[s].get();
+      }
+      if (load != nullptr) {
+        load->addEgg(busy);
+      }
+      row.swap(next);
+    }
+  }
+
+ private:
+  // Cells [lo, hi) of the row after the egg, with its taken bits; lo is a
+  // multiple of 64.
+  static void relaxStripe(const Cell *curr, Cell *next, uint64_t *taken,
+                          uint64_t lo, uint64_t hi, uint64_t size,
+                          uint64_t weight) {
+    for (uint64_t word = lo; word < hi; word += 64) {
+      uint64_t end = std::min(hi, word + 64);
+      uint64_t from = std::min(end, std::max(word, size));
+      std::copy(curr + word, curr + from, next + word);
+      taken[word / 64] =
+          from == end ? 0
+                      : relaxTaken(next + from, curr + from, curr + from - size,
+                                   end - from, weight)
+                            << (from - word);
+    }
+  }
+
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+  SweepLoad *load;
+};
+
+#endif  // SRC_CHOICE_BITS_H_
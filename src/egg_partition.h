@@ -0,0 +1,169 @@
+#ifndef SRC_EGG_PARTITION_H_
+#define SRC_EGG_PARTITION_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "knapsack.h"
+
+// Row of the best packing of two independent egg groups: the (max, +)
+// convolution out[c] = max over a <= c of front[a] + back[c - a], for cells
+// [lo, hi). Rows hold best weights for "at most" a capacity, so every split
+// of c is a valid packing.
+void maxPlusMerge(std::vector<uint64_t> const &front,
+                  std::vector<uint64_t> const &back, uint64_t lo, uint64_t hi,
+                  std::vector<uint64_t> &out) {
+  for (uint64_t c = lo; c < hi; c++) {
+    uint64_t best = 0;
+    for (uint64_t a = 0; a <= c; a++) {
+      best = std::max(best, front[a] + back[c - a]);
+    }
+    out[c] = best;
+  }
+}
+
+// Knapsack parallelized over eggs instead of capacities, for many eggs and a
+// short row. Every shaman sweeps the row of its own group of eggs without
+// any synchronization, then group rows are combined pairwise by
+// maxPlusMerge() in a tree. Splitting the eggs saves M * N * (1 - 1 / G) of
+// sweeping with G shamans, and the tree costs about N^2 / 2 * (1 - 1 / G).
+//
+// Eggs are recovered top-down: the best split of a node's capacity between
+// its two children is read from their rows, and every group finally packs
+// its own capacity with RollingRowPacker, again in parallel.
+class EggPartitionPacker {
+ public:
+  EggPartitionPacker(ThreadPool &councilArg, uint64_t numberOfShamansArg)
+      : council(councilArg), numberOfShamans(numberOfShamansArg) {}
+
+  // True when the merge tree costs at most half of the sweeping it saves,
+  // which is when there are more eggs than capacities.
+  static bool pays(std::vector<PackItem> const &items, uint64_t capacity,
+                   uint64_t numberOfShamans) {
+    return numberOfShamans > 1 && capacity < items.size();
+  }
+
+  Packing pack(std::vector<PackItem> const &items, uint64_t capacity) {
+    uint64_t groups = std::max<uint64_t>(
+        1, std::min<uint64_t>(numberOfShamans, items.size()));
+    std::vector<size_t> bounds;
+    for (uint64_t g = 0; g <= groups; g++) {
+      bounds.push_back(items.size() * g / groups);
+    }
+
+    // levels[0] holds the group rows, levels[l + 1][j] merges rows 2j and
+    // 2j + 1 of levels[l]; an odd row out is carried up as it is.
+    std::vector<std::vector<std::vector<uint64_t>>> levels(1);
+    levels[0].assign(groups, std::vector<uint64_t>(capacity + 1));
+    {
+      std::vector<std::future<void>> results;
+      for (uint64_t g = 0; g < groups; g++) {
+        results.emplace_back(
+            council.enqueue([g, &items, &bounds, &levels] {
+              SequentialSweeper<uint64_t>().sweep(
+                  items, bounds[g], bounds[g + 1], levels[0][g]);
+            }));
+      }
+      for (auto &&result : results) {
+        result.get();
+      }
+    }
+    while (levels.back().size() > 1) {
+      levels.push_back(mergeLevel(levels.back(), capacity));
+    }
+
+    std::vector<uint64_t> room{capacity};
+    for (size_t l = levels.size() - 1; l-- > 0;) {
+      std::vector<uint64_t> below;
+      for (size_t j = 0; j < room.size(); j++) {
+        if (2 * j + 1 == levels[l].size()) {
+          below.push_back(room[j]);
+          continue;
+        }
+        std::vector<uint64_t> const &front = levels[l][2 * j];
+        std::vector<uint64_t> const &back = levels[l][2 * j + 1];
+        uint64_t split = 0;
+        for (uint64_t a = 0; a <= room[j]; a++) {
+          if (front[a] + back[room[j] - a] >
+              front[split] + back[room[j] - split]) {
+            split = a;
+          }
+        }
+        below.push_back(split);
+        below.push_back(room[j] - split);
+      }
+      room.swap(below);
+    }
+    levels.clear();
+
+    std::vector<Packing> packings(groups);
+    {
+      std::vector<std::future<void>> results;
+      for (uint64_t g = 0; g < groups; g++) {
+        results.emplace_back(
+            council.enqueue([g, &items, &bounds, &room, &packings] {
+              std::vector<PackItem> group(items.begin() + bounds[g],
+                                          items.begin() + bounds[g + 1]);
+              SequentialSweeper<uint64_t> sweeper;
+              packings[g] =
+                  RollingRowPacker<uint64_t>(sweeper).pack(group, room[g]);
+            }));
+      }
+      for (auto &&result : results) {
+        result.get();
+      }
+    }
+
+    Packing packing;
+    for (uint64_t g = 0; g < groups; g++) {
+      packing.weight += packings[g].weight;
+      for (auto index : packings[g].chosen) {
+        packing.chosen.push_back(bounds[g] + index);
+      }
+    }
+    return packing;
+  }
+
+ private:
+  // Every merge of the level is split into stripes of about equal work;
+  // cell c costs c + 1, so stripe boundaries grow like a square root.
+  std::vector<std::vector<uint64_t>> mergeLevel(
+      std::vector<std::vector<uint64_t>> const &rows, uint64_t capacity) {
+    uint64_t N = capacity + 1;
+    uint64_t merges = rows.size() / 2;
+    uint64_t stripes = numberOfShamans / merges + 1;
+
+    std::vector<std::vector<uint64_t>> merged((rows.size() + 1) / 2);
+    std::vector<std::future<void>> results;
+    for (uint64_t j = 0; j < merges; j++) {
+      merged[j].resize(N);
+      for (uint64_t s = 0; s < stripes; s++) {
+        uint64_t lo = N * std::sqrt(static_cast<double>(s) / stripes);
+        uint64_t hi =
+            s + 1 == stripes
+                ? N
+                : N * std::sqrt(static_cast<double>(s + 1) / stripes);
+        if (lo < hi) {
+          results.emplace_back(council.enqueue([j, lo, hi, &rows, &merged] {
+            maxPlusMerge(rows[2 * j], rows[2 * j + 1], lo, hi, merged[j]);
+          }));
+        }
+      }
+    }
+    for (auto &&result : results) {
+      result.get();
+    }
+    if (rows.size() % 2 == 1) {
+      merged.back() = rows.back();
+    }
+    return merged;
+  }
+
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+};
+
+#endif  // SRC_EGG_PARTITION_H_
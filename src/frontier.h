@@ -0,0 +1,192 @@
+#ifndef SRC_FRONTIER_H_
+#define SRC_FRONTIER_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "knapsack.h"
+
+// A packing that no other packing beats with a smaller or equal size.
+struct FrontierPoint {
+  uint64_t size;
+  uint64_t weight;
+};
+
+// True when capacity-indexed rows for this input fit in memory.
+bool rowsFit(std::vector<PackItem> const &items, uint64_t capacity) {
+  const uint64_t maxRowCells = 1ULL << 28;
+
+  return std::min(capacity, totalSize(items)) <= maxRowCells;
+}
+
+// True when a capacity-indexed DP would be wasteful: its rows would not fit
+// in memory, or the frontier cannot grow past a small fraction of a row
+// because there are only 2^M subsets.
+bool prefersFrontier(std::vector<PackItem> const &items, uint64_t capacity) {
+  const uint64_t rowCellsPerPoint = 16;
+
+  if (!rowsFit(items, capacity)) {
+    return true;
+  }
+  uint64_t span = std::min(capacity, totalSize(items));
+  return items.size() < 64 &&
+         (1ULL << items.size()) <= span / rowCellsPerPoint;
+}
+
+// Knapsack over the sorted list of non-dominated (size, weight) pairs
+// instead of a capacity-indexed row, so work and memory follow the
+// frontier and a capacity of 10^12 costs nothing by itself.
+//
+// Eggs are recovered like in RollingRowPacker: the egg list is halved, the
+// best pair of points of the two half frontiers gives the room of each
+// half. The recursion is run level by level and with a council all
+// frontiers of a level are built in parallel.
+class FrontierPacker {
+ public:
+  explicit FrontierPacker(ThreadPool *councilArg) : council(councilArg) {}
+
+  Packing pack(std::vector<PackItem> const &items, uint64_t capacity) {
+    Packing packing;
+    std::vector<Node> level{{0, items.size(), capacity}};
+
+    while (!level.empty()) {
+      std::vector<Node> split;
+      for (auto &node : level) {
+        if (!solveDirectly(items, node, packing)) {
+          split.push_back(node);
+        }
+      }
+
+      std::vector<std::vector<FrontierPoint>> frontiers(2 * split.size());
+      std::vector<std::future<void>> results;
+      for (size_t n = 0; n < frontiers.size(); n++) {
+        Node node = split[n / 2];
+        size_t mid = node.first + (node.last - node.first) / 2;
+        size_t first = n % 2 == 0 ? node.first : mid;
+        size_t last = n % 2 == 0 ? mid : node.last;
+        auto build = [&items, &frontiers, n, first, last, node] {
+          frontiers[n] = frontier(items, first, last, node.capacity);
+        };
+        if (council == nullptr) {
+          build();
+        } else {
+          results.emplace_back(council->enqueue(build));
+        }
+      }
+      for (auto &&result : results) {
+        result.get();
+      }
+
+      level.clear();
+      for (size_t n = 0; n < split.size(); n++) {
+        Node node = split[n];
+        size_t mid = node.first + (node.last - node.first) / 2;
+        std::pair<uint64_t, uint64_t> room =
+            bestPair(frontiers[2 * n], frontiers[2 * n + 1], node.capacity);
+        level.push_back({node.first, mid, room.first});
+        level.push_back({mid, node.last, room.second});
+      }
+    }
+
+    std::sort(packing.chosen.begin(), packing.chosen.end());
+    return packing;
+  }
+
+  // Non-dominated packings of items [first, last) that fit in `capacity`,
+  // sorted by size; weights strictly increase along the list.
+  static std::vector<FrontierPoint> frontier(
+      std::vector<PackItem> const &items, size_t first, size_t last,
+      uint64_t capacity) {
+    std::vector<FrontierPoint> points{{0, 0}}, merged;
+    for (size_t i = first; i < last; i++) {
+      uint64_t size = items[i].size, weight = items[i].weight;
+      if (size > capacity || weight == 0) {
+        continue;
+      }
+
+      merged.clear();
+      merged.reserve(2 * points.size());
+      size_t kept = 0, taken = 0;
+      while (kept < points.size() || taken < points.size()) {
+        bool canTake =
+            taken < points.size() && points[taken].size <= capacity - size;
+        if (!canTake && kept == points.size()) {
+          break;
+        }
+
+        FrontierPoint next;
+        if (!canTake ||
+            (kept < points.size() && points[kept].size <= points[taken].size +
+                                                              size)) {
+          next = points[kept++];
+        } else {
+          next = {points[taken].size + size, points[taken].weight + weight};
+          taken++;
+        }
+
+        if (!merged.empty() && merged.back().size == next.size) {
+          merged.back().weight = std::max(merged.back().weight, next.weight);
+        } else if (merged.empty() || next.weight > merged.back().weight) {
+          merged.push_back(next);
+        }
+      }
+      points.swap(merged);
+    }
+    return points;
+  }
+
+ private:
+  struct Node {
+    size_t first, last;
+    uint64_t capacity;
+  };
+
+  // Leaves and ranges that fit whole are packed without any frontier.
+  static bool solveDirectly(std::vector<PackItem> const &items,
+                            Node const &node, Packing &packing) {
+    // Compared against the room left, so huge sizes cannot wrap around.
+    bool fits = true;
+    uint64_t total = 0;
+    for (size_t i = node.first; i < node.last && fits; i++) {
+      fits = items[i].size <= node.capacity - total;
+      total += fits ? items[i].size : 0;
+    }
+    if (node.last - node.first > 1 && !fits) {
+      return false;
+    }
+
+    for (size_t i = node.first; i < node.last; i++) {
+      if (items[i].size <= node.capacity && items[i].weight > 0) {
+        packing.weight += items[i].weight;
+        packing.chosen.push_back(i);
+      }
+    }
+    return true;
+  }
+
+  // Sizes of the heaviest pair of points that fits in `capacity`. Walking
+  // `front` up in size only moves the matching point of `back` down.
+  static std::pair<uint64_t, uint64_t> bestPair(
+      std::vector<FrontierPoint> const &front,
+      std::vector<FrontierPoint> const &back, uint64_t capacity) {
+    std::pair<uint64_t, uint64_t> best(0, 0);
+    uint64_t bestWeight = 0;
+    size_t b = back.size() - 1;
+    for (auto &point : front) {
+      while (back[b].size > capacity - point.size) {
+        b--;
+      }
+      if (point.weight + back[b].weight > bestWeight) {
+        bestWeight = point.weight + back[b].weight;
+        best = {point.size, back[b].size};
+      }
+    }
+    return best;
+  }
+
+  ThreadPool *council;
+};
+
+#endif  // SRC_FRONTIER_H_
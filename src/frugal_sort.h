@@ -0,0 +1,140 @@
+#ifndef SRC_FRUGAL_SORT_H_
+#define SRC_FRUGAL_SORT_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+
+// Building blocks of a sort that spends as few calls to operator< as it
+// can, for elements whose comparison costs far more than moving them. All
+// of them keep equal elements in order.
+
+// Insertion sort that finds every place by binary search: about
+// log2(k!) comparisons for k elements, which is close to the minimum for
+// short ranges, at the price of O(k^2) moves.
+template <class Iterator>
+void binaryInsertionSort(Iterator first, Iterator last) {
+  for (Iterator it = first; it != last; ++it) {
+    Iterator place = std::upper_bound(first, it, *it);
+    std::rotate(place, it, it + 1);
+  }
+}
+
+// First element of [first, last) that `value` goes before, searched from
+// the front with steps 1, 2, 4, ... and then by bisection: 2 log2(d)
+// comparisons for an answer d elements in.
+template <class Iterator, class T>
+Iterator gallopUpper(Iterator first, Iterator last, T const &value) {
+  typename std::iterator_traits<Iterator>::difference_type step = 1,
+                                                            done = 0;
+  while (step <= last - first && !(value < *(first + (step - 1)))) {
+    done = step;
+    step *= 2;
+  }
+  return std::upper_bound(first + done, first + std::min(step, last - first),
+                          value);
+}
+
+// Like gallopUpper(), for the first element that is not below `value`.
+template <class Iterator, class T>
+Iterator gallopLower(Iterator first, Iterator last, T const &value) {
+  typename std::iterator_traits<Iterator>::difference_type step = 1,
+                                                            done = 0;
+  while (step <= last - first && *(first + (step - 1)) < value) {
+    done = step;
+    step *= 2;
+  }
+  return std::lower_bound(first + done, first + std::min(step, last - first),
+                          value);
+}
+
+// std::merge() that switches to galloping once one side wins
+// `minGallop` times in a row, so long runs from one side cost a logarithmic
+// number of comparisons instead of one per element. An element of the
+// first range goes before an equal one of the second.
+template <class Iterator, class Output>
+Output gallopMerge(Iterator a, Iterator aLast, Iterator b, Iterator bLast,
+                   Output out) {
+  const int minGallop = 7;
+
+  int winsA = 0, winsB = 0;
+  while (a != aLast && b != bLast) {
+    if (*b < *a) {
+      *out++ = *b++;
+      winsB++;
+      winsA = 0;
+    } else {
+      *out++ = *a++;
+      winsA++;
+      winsB = 0;
+    }
+    if (winsA >= minGallop && b != bLast) {
+      Iterator end = gallopUpper(a, aLast, *b);
+      out = std::copy(a, end, out);
+      a = end;
+      winsA = 0;
+    } else if (winsB >= minGallop && a != aLast) {
+      Iterator end = gallopLower(b, bLast, *a);
+      out = std::copy(b, end, out);
+      b = end;
+      winsB = 0;
+    }
+  }
+  out = std::copy(a, aLast, out);
+  return std::copy(b, bLast, out);
+}
+
+// Sorts [first, last) with binaryInsertionSort() on short leaves and
+// gallopMerge() between them, bottom up, back and forth with the scratch
+// range that starts at `scratch` and is as long.
+template <class Iterator>
+void frugalSort(Iterator first, Iterator last, Iterator scratch) {
+  typedef typename std::iterator_traits<Iterator>::difference_type Distance;
+  const Distance leafSize = 32;
+
+  Distance n = last - first;
+  for (Distance lo = 0; lo < n; lo += leafSize) {
+    binaryInsertionSort(first + lo, first + std::min(n, lo + leafSize));
+  }
+  Iterator from = first, to = scratch;
+  for (Distance width = leafSize; width < n; width *= 2) {
+    for (Distance lo = 0; lo < n; lo += 2 * width) {
+      Distance mid = std::min(n, lo + width), hi = std::min(n, lo + 2 * width);
+      gallopMerge(from + lo, from + mid, from + mid, from + hi, to + lo);
+    }
+    std::swap(from, to);
+  }
+  if (from != first) {
+    std::copy(from, from + n, first);
+  }
+}
+
+// Element wrapper that counts calls to operator<, to compare sorts by the
+// comparisons they make. The count is shared by all wrappers of T.
+template <class T>
+class Counted {
+ public:
+  Counted() : value() {}
+
+  Counted(T const &valueArg) : value(valueArg) {}  // NOLINT
+
+  bool operator<(Counted const &other) const {
+    comparisons()++;
+    return value < other.value;
+  }
+
+  bool operator==(Counted const &other) const { return value == other.value; }
+
+  T const &get() const { return value; }
+
+  static std::atomic<uint64_t> &comparisons() {
+    static std::atomic<uint64_t> count(0);
+    return count;
+  }
+
+ private:
+  T value;
+};
+
+#endif  // SRC_FRUGAL_SORT_H_
@@ -0,0 +1,360 @@
+#ifndef SRC_KERNELS_H_
+#define SRC_KERNELS_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SHAMANS_X86_KERNELS
+#endif
+
+// Knapsack row kernel: dst[i] = max(keep[i], take[i] + weight) for i in
+// [0, count). Cells are processed from the highest index down and every
+// chunk is loaded before it is stored, so it is safe to call in place with
+// dst == keep and take == keep - size. Cells are uint16_t, uint32_t or
+// uint64_t; the caller guarantees that take[i] + weight does not overflow.
+template <class Cell>
+struct RelaxRowKernel {
+  typedef void (*Type)(Cell *dst, const Cell *keep, const Cell *take,
+                       uint64_t count, Cell weight);
+};
+
+template <class Cell>
+void relaxRowScalar(Cell *dst, const Cell *keep, const Cell *take,
+                    uint64_t count, Cell weight) {
+  for (uint64_t i = count; i-- > 0;) {
+    dst[i] = std::max(keep[i], static_cast<Cell>(take[i] + weight));
+  }
+}
+
+#ifdef SHAMANS_X86_KERNELS
+__attribute__((target("avx2"))) void relaxRowAvx2(uint64_t *dst,
+                                                  const uint64_t *keep,
+                                                  const uint64_t *take,
+                                                  uint64_t count,
+                                                  uint64_t weight) {
+  // AVX2 only compares signed lanes; flipping the sign bit of both sides
+  // turns it into an unsigned comparison.
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i w = _mm256_set1_epi64x(weight);
+  uint64_t i = count;
+  while (i >= 4) {
+    i -= 4;
+    __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keep + i));
+    __m256i t = _mm256_add_epi64(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(take + i)), w);
+    __m256i takeIsBigger = _mm256_cmpgt_epi64(_mm256_xor_si256(t, sign),
+                                              _mm256_xor_si256(k, sign));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm256_blendv_epi8(k, t, takeIsBigger));
+  }
+  relaxRowScalar(dst, keep, take, i, weight);
+}
+
+__attribute__((target("avx2"))) void relaxRowAvx2(uint32_t *dst,
+                                                  const uint32_t *keep,
+                                                  const uint32_t *take,
+                                                  uint64_t count,
+                                                  uint32_t weight) {
+  const __m256i w = _mm256_set1_epi32(weight);
+  uint64_t i = count;
+  while (i >= 8) {
+    i -= 8;
+    __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keep + i));
+    __m256i t = _mm256_add_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(take + i)), w);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm256_max_epu32(k, t));
+  }
+  relaxRowScalar(dst, keep, take, i, weight);
+}
+
+__attribute__((target("avx2"))) void relaxRowAvx2(uint16_t *dst,
+                                                  const uint16_t *keep,
+                                                  const uint16_t *take,
+                                                  uint64_t count,
+                                                  uint16_t weight) {
+  const __m256i w = _mm256_set1_epi16(weight);
+  uint64_t i = count;
+  while (i >= 16) {
+    i -= 16;
+    __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keep + i));
+    __m256i t = _mm256_add_epi16(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(take + i)), w);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm256_max_epu16(k, t));
+  }
+  relaxRowScalar(dst, keep, take, i, weight);
+}
+
+__attribute__((target("avx512f"))) void relaxRowAvx512(uint64_t *dst,
+                                                      const uint64_t *keep,
+                                                      const uint64_t *take,
+                                                      uint64_t count,
+                                                      uint64_t weight) {
+  const __m512i w = _mm512_set1_epi64(weight);
+  uint64_t i = count;
+  while (i >= 8) {
+    i -= 8;
+    __m512i k = _mm512_loadu_si512(keep + i);
+    __m512i t = _mm512_add_epi64(_mm512_loadu_si512(take + i), w);
+    // Compare and blend rather than _mm512_max_epu64(), whose GCC 12
+    // wrapper passes an undefined source that -O2 reports as uninitialized;
+    // the narrower kernels below do the same.
+    __mmask8 takeIsBigger = _mm512_cmpgt_epu64_mask(t, k);
+    _mm512_storeu_si512(dst + i, _mm512_mask_blend_epi64(takeIsBigger, k, t));
+  }
+  relaxRowScalar(dst, keep, take, i, weight);
+}
+
+__attribute__((target("avx512f"))) void relaxRowAvx512(uint32_t *dst,
+                                                      const uint32_t *keep,
+                                                      const uint32_t *take,
+                                                      uint64_t count,
+                                                      uint32_t weight) {
+  const __m512i w = _mm512_set1_epi32(weight);
+  uint64_t i = count;
+  while (i >= 16) {
+    i -= 16;
+    __m512i k = _mm512_loadu_si512(keep + i);
+    __m512i t = _mm512_add_epi32(_mm512_loadu_si512(take + i), w);
+    __mmask16 takeIsBigger = _mm512_cmpgt_epu32_mask(t, k);
+    _mm512_storeu_si512(dst + i, _mm512_mask_blend_epi32(takeIsBigger, k, t));
+  }
+  relaxRowScalar(dst, keep, take, i, weight);
+}
+
+__attribute__((target("avx512f,avx512bw"))) void relaxRowAvx512(
+    uint16_t *dst, const uint16_t *keep, const uint16_t *take, uint64_t count,
+    uint16_t weight) {
+  const __m512i w = _mm512_set1_epi16(weight);
+  uint64_t i = count;
+  while (i >= 32) {
+    i -= 32;
+    __m512i k = _mm512_loadu_si512(keep + i);
+    __m512i t = _mm512_add_epi16(_mm512_loadu_si512(take + i), w);
+    __mmask32 takeIsBigger = _mm512_cmpgt_epu16_mask(t, k);
+    _mm512_storeu_si512(dst + i, _mm512_mask_blend_epi16(takeIsBigger, k, t));
+  }
+  relaxRowScalar(dst, keep, take, i, weight);
+}
+#endif
+
+// Picks the widest kernel the CPU supports for the cell type, once per type.
+// The 16-bit AVX-512 kernel also needs AVX-512BW.
+template <class Cell>
+typename RelaxRowKernel<Cell>::Type selectRelaxRowKernel() {
+#ifdef SHAMANS_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") &&
+      (sizeof(Cell) > 2 || __builtin_cpu_supports("avx512bw"))) {
+    return relaxRowAvx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return relaxRowAvx2;
+  }
+#endif
+  return relaxRowScalar<Cell>;
+}
+
+template <class Cell>
+void relaxRow(Cell *dst, const Cell *keep, const Cell *take, uint64_t count,
+              uint64_t weight) {
+  static const typename RelaxRowKernel<Cell>::Type kernel =
+      selectRelaxRowKernel<Cell>();
+  kernel(dst, keep, take, count, static_cast<Cell>(weight));
+}
+
+// Like RelaxRowKernel for at most 64 cells, also returning bit i set when
+// take[i] + weight won over keep[i]: the taken bits of ChoiceBits. dst must
+// not overlap keep or take.
+template <class Cell>
+struct RelaxTakenKernel {
+  typedef uint64_t (*Type)(Cell *dst, const Cell *keep, const Cell *take,
+                           uint64_t count, Cell weight);
+};
+
+template <class Cell>
+uint64_t relaxTakenScalar(Cell *dst, const Cell *keep, const Cell *take,
+                          uint64_t count, Cell weight) {
+  uint64_t bits = 0;
+  for (uint64_t i = 0; i < count; i++) {
+    Cell t = static_cast<Cell>(take[i] + weight);
+    dst[i] = std::max(keep[i], t);
+    bits |= static_cast<uint64_t>(t > keep[i]) << i;
+  }
+  return bits;
+}
+
+#ifdef SHAMANS_X86_KERNELS
+// The AVX2 kernels flip the sign bit of both sides to compare unsigned
+// lanes, and gather one bit per lane with a movemask.
+__attribute__((target("avx2"))) uint64_t relaxTakenAvx2(uint64_t *dst,
+                                                        const uint64_t *keep,
+                                                        const uint64_t *take,
+                                                        uint64_t count,
+                                                        uint64_t weight) {
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i w = _mm256_set1_epi64x(weight);
+  uint64_t bits = 0, i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keep + i));
+    __m256i t = _mm256_add_epi64(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(take + i)), w);
+    __m256i takeIsBigger = _mm256_cmpgt_epi64(_mm256_xor_si256(t, sign),
+                                              _mm256_xor_si256(k, sign));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm256_blendv_epi8(k, t, takeIsBigger));
+    bits |= static_cast<uint64_t>(
+                _mm256_movemask_pd(_mm256_castsi256_pd(takeIsBigger)))
+            << i;
+  }
+  if (i < count) {
+    bits |= relaxTakenScalar(dst + i, keep + i, take + i, count - i, weight)
+            << i;
+  }
+  return bits;
+}
+
+__attribute__((target("avx2"))) uint64_t relaxTakenAvx2(uint32_t *dst,
+                                                        const uint32_t *keep,
+                                                        const uint32_t *take,
+                                                        uint64_t count,
+                                                        uint32_t weight) {
+  const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+  const __m256i w = _mm256_set1_epi32(weight);
+  uint64_t bits = 0, i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keep + i));
+    __m256i t = _mm256_add_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(take + i)), w);
+    __m256i takeIsBigger = _mm256_cmpgt_epi32(_mm256_xor_si256(t, sign),
+                                              _mm256_xor_si256(k, sign));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm256_max_epu32(k, t));
+    bits |= static_cast<uint64_t>(
+                _mm256_movemask_ps(_mm256_castsi256_ps(takeIsBigger)))
+            << i;
+  }
+  if (i < count) {
+    bits |= relaxTakenScalar(dst + i, keep + i, take + i, count - i, weight)
+            << i;
+  }
+  return bits;
+}
+
+__attribute__((target("avx2"))) uint64_t relaxTakenAvx2(uint16_t *dst,
+                                                        const uint16_t *keep,
+                                                        const uint16_t *take,
+                                                        uint64_t count,
+                                                        uint16_t weight) {
+  const __m256i sign = _mm256_set1_epi16(INT16_MIN);
+  const __m256i w = _mm256_set1_epi16(weight);
+  uint64_t bits = 0, i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keep + i));
+    __m256i t = _mm256_add_epi16(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(take + i)), w);
+    __m256i takeIsBigger = _mm256_cmpgt_epi16(_mm256_xor_si256(t, sign),
+                                              _mm256_xor_si256(k, sign));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm256_max_epu16(k, t));
+    // Packing to bytes works within 128-bit halves; the permute puts the
+    // 16 bytes of the mask next to each other.
+    __m256i bytes = _mm256_permute4x64_epi64(
+        _mm256_packs_epi16(takeIsBigger, _mm256_setzero_si256()), 0xd8);
+    bits |= static_cast<uint64_t>(
+                static_cast<uint32_t>(_mm256_movemask_epi8(bytes)))
+            << i;
+  }
+  if (i < count) {
+    bits |= relaxTakenScalar(dst + i, keep + i, take + i, count - i, weight)
+            << i;
+  }
+  return bits;
+}
+
+__attribute__((target("avx512f"))) uint64_t relaxTakenAvx512(
+    uint64_t *dst, const uint64_t *keep, const uint64_t *take, uint64_t count,
+    uint64_t weight) {
+  const __m512i w = _mm512_set1_epi64(weight);
+  uint64_t bits = 0, i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m512i k = _mm512_loadu_si512(keep + i);
+    __m512i t = _mm512_add_epi64(_mm512_loadu_si512(take + i), w);
+    __mmask8 takeIsBigger = _mm512_cmpgt_epu64_mask(t, k);
+    _mm512_storeu_si512(dst + i, _mm512_mask_blend_epi64(takeIsBigger, k, t));
+    bits |= static_cast<uint64_t>(takeIsBigger) << i;
+  }
+  if (i < count) {
+    bits |= relaxTakenScalar(dst + i, keep + i, take + i, count - i, weight)
+            << i;
+  }
+  return bits;
+}
+
+__attribute__((target("avx512f"))) uint64_t relaxTakenAvx512(
+    uint32_t *dst, const uint32_t *keep, const uint32_t *take, uint64_t count,
+    uint32_t weight) {
+  const __m512i w = _mm512_set1_epi32(weight);
+  uint64_t bits = 0, i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m512i k = _mm512_loadu_si512(keep + i);
+    __m512i t = _mm512_add_epi32(_mm512_loadu_si512(take + i), w);
+    __mmask16 takeIsBigger = _mm512_cmpgt_epu32_mask(t, k);
+    _mm512_storeu_si512(dst + i, _mm512_mask_blend_epi32(takeIsBigger, k, t));
+    bits |= static_cast<uint64_t>(takeIsBigger) << i;
+  }
+  if (i < count) {
+    bits |= relaxTakenScalar(dst + i, keep + i, take + i, count - i, weight)
+            << i;
+  }
+  return bits;
+}
+
+__attribute__((target("avx512f,avx512bw"))) uint64_t relaxTakenAvx512(
+    uint16_t *dst, const uint16_t *keep, const uint16_t *take, uint64_t count,
+    uint16_t weight) {
+  const __m512i w = _mm512_set1_epi16(weight);
+  uint64_t bits = 0, i = 0;
+  for (; i + 32 <= count; i += 32) {
+    __m512i k = _mm512_loadu_si512(keep + i);
+    __m512i t = _mm512_add_epi16(_mm512_loadu_si512(take + i), w);
+    __mmask32 takeIsBigger = _mm512_cmpgt_epu16_mask(t, k);
+    _mm512_storeu_si512(dst + i, _mm512_mask_blend_epi16(takeIsBigger, k, t));
+    bits |= static_cast<uint64_t>(takeIsBigger) << i;
+  }
+  if (i < count) {
+    bits |= relaxTakenScalar(dst + i, keep + i, take + i, count - i, weight)
+            << i;
+  }
+  return bits;
+}
+#endif
+
+// Picks the taken-bit kernel like selectRelaxRowKernel().
+template <class Cell>
+typename RelaxTakenKernel<Cell>::Type selectRelaxTakenKernel() {
+#ifdef SHAMANS_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") &&
+      (sizeof(Cell) > 2 || __builtin_cpu_supports("avx512bw"))) {
+    return relaxTakenAvx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return relaxTakenAvx2;
+  }
+#endif
+  return relaxTakenScalar<Cell>;
+}
+
+template <class Cell>
+uint64_t relaxTaken(Cell *dst, const Cell *keep, const Cell *take,
+                    uint64_t count, uint64_t weight) {
+  static const typename RelaxTakenKernel<Cell>::Type kernel =
+      selectRelaxTakenKernel<Cell>();
+  return kernel(dst, keep, take, count, static_cast<Cell>(weight));
+}
+
+#endif  // SRC_KERNELS_H_
@@ -0,0 +1,75 @@
+#ifndef SRC_KEY_SELECT_H_
+#define SRC_KEY_SELECT_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "radix_sort.h"
+#include "sorting.h"
+
+// How TeamAdventure selects the best crystal.
+enum class CrystalSelection {
+  // Every shaman runs std::max_element() over a chunk with operator<.
+  Comparisons,
+  // Crystals compared by their SortKey, read once per crystal.
+  Keys,
+};
+
+// Finds the greatest element by its SortKey instead of by operator<, which
+// may cost far more than reading the key. The shamans reduce over chunks of
+// the keys at once.
+//
+// Must be called from outside the council.
+template <class T>
+class KeySelector {
+ public:
+  KeySelector(ThreadPool &councilArg, uint64_t numberOfShamansArg)
+      : council(councilArg), numberOfShamans(numberOfShamansArg) {}
+
+  // The first of the greatest elements; T() if there are none.
+  T max(std::vector<T> const &values) {
+    uint64_t n = values.size();
+    if (n == 0) {
+      return T();
+    }
+    uint64_t chunks = chunksFor(n);
+    std::vector<KeyedIndex> best(chunks, KeyedIndex{0, n});
+    runChunks(council, n, chunks, [&](uint64_t c, uint64_t lo, uint64_t hi) {
+      KeyedIndex &chunkBest = best[c];
+      chunkBest = KeyedIndex{SortKey<T>::of(values[lo]), lo};
+      for (uint64_t i = lo + 1; i < hi; i++) {
+        uint64_t key = SortKey<T>::of(values[i]);
+        if (chunkBest.key < key) {
+          chunkBest = KeyedIndex{key, i};
+        }
+      }
+    });
+    KeyedIndex result = best[0];
+    for (KeyedIndex const &chunkBest : best) {
+      if (result.key < chunkBest.key) {
+        result = chunkBest;
+      }
+    }
+    return values[result.index];
+  }
+
+ private:
+  // The SortKey of an element together with where the element is.
+  struct KeyedIndex {
+    uint64_t key;
+    uint64_t index;
+  };
+
+  uint64_t chunksFor(uint64_t n) const {
+    const uint64_t threshold = 1 << 12;
+
+    return std::min(numberOfShamans, n / threshold + 1);
+  }
+
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+};
+
+#endif  // SRC_KEY_SELECT_H_
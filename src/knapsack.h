@@ -0,0 +1,741 @@
+#ifndef SRC_KNAPSACK_H_
+#define SRC_KNAPSACK_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "kernels.h"
+#include "types.h"
+
+// Size and weight of an egg, read once so that the DP never pays for
+// Egg::getWeight() more than once per egg.
+struct PackItem {
+  uint64_t size;
+  uint64_t weight;
+};
+
+// Result of a knapsack engine: total weight and indices of the chosen eggs.
+struct Packing {
+  Packing() : weight(0) {}
+
+  uint64_t weight;
+  std::vector<size_t> chosen;
+};
+
+enum class PackingEngine {
+  // Picks the engine from the shape of the input.
+  Auto,
+  // One sweep recording a taken bit per (egg, capacity), when the bits fit
+  // in memory.
+  Table,
+  // Two rolling rows with divide-and-conquer reconstruction.
+  RollingRows,
+  // Bitset of reachable sizes, when weights are proportional to sizes.
+  SubsetSum,
+  // Sorted list of non-dominated (size, weight) pairs, for huge capacities.
+  Frontier,
+  // Sorted subset sums of both halves of the eggs, for few eggs.
+  MeetInTheMiddle,
+  // Independent rows per group of eggs merged by (max, +), for short rows.
+  EggPartition,
+  // Smallest size per total weight, for light eggs in an enormous bag.
+  WeightIndexed,
+  // Depth-first search cut by fractional bounds, for many eggs of differing
+  // density in a huge bag.
+  BranchAndBound,
+};
+
+// How the threaded engines hand a row to the shamans.
+enum class SweepSchedule {
+  // One task and one future per stripe and egg.
+  Futures,
+  // One long-lived task per stripe, synchronized by a barrier after each egg.
+  Barrier,
+  // Cache-sized tiles of (egg block, capacity block) run as a wavefront.
+  Wavefront,
+  // Like Barrier, with every stripe first-touched by and pinned to the NUMA
+  // node of its shaman.
+  NumaLocal,
+  // One forked process per stripe, passing halos over shared memory.
+  Processes,
+};
+
+std::vector<PackItem> readItems(std::vector<Egg> &eggs) {
+  std::vector<PackItem> items;
+  items.reserve(eggs.size());
+  for (auto &egg : eggs) {
+    items.push_back({egg.getSize(), egg.getWeight()});
+  }
+  return items;
+}
+
+uint64_t fillBag(std::vector<Egg> const &eggs, Packing const &packing,
+                 BottomlessBag &bag) {
+  for (auto index : packing.chosen) {
+    bag.addEgg(eggs[index]);
+  }
+  return packing.weight;
+}
+
+// Sum of egg weights of items [first, last), saturated instead of wrapping
+// around.
+uint64_t totalWeight(std::vector<PackItem> const &items, size_t first,
+                     size_t last) {
+  uint64_t total = 0;
+  for (size_t i = first; i < last; i++) {
+    uint64_t weight = items[i].weight;
+    total = weight > UINT64_MAX - total ? UINT64_MAX : total + weight;
+  }
+  return total;
+}
+
+// Sum of egg sizes, saturated instead of wrapping around.
+uint64_t totalSize(std::vector<PackItem> const &items) {
+  uint64_t total = 0;
+  for (auto &item : items) {
+    total = item.size > UINT64_MAX - total ? UINT64_MAX : total + item.size;
+  }
+  return total;
+}
+
+// Cell types of capacity-indexed rows.
+enum class CellWidth { Bits16, Bits32, Bits64 };
+
+// Cells hold sums of egg weights, so the narrowest type that holds the total
+// weight of all eggs never overflows.
+CellWidth narrowestCell(std::vector<PackItem> const &items) {
+  uint64_t weights = totalWeight(items, 0, items.size());
+  if (weights <= UINT16_MAX) {
+    return CellWidth::Bits16;
+  }
+  return weights <= UINT32_MAX ? CellWidth::Bits32 : CellWidth::Bits64;
+}
+
+// True when every egg weighs the same multiple of its size, so that the
+// heaviest packing is the fullest one.
+bool isSubsetSum(std::vector<PackItem> const &items) {
+  uint64_t ratio = 0;
+  bool haveRatio = false;
+  for (auto &item : items) {
+    if (item.size == 0) {
+      if (item.weight != 0) {
+        return false;
+      }
+      continue;
+    }
+    if (!haveRatio) {
+      ratio = item.weight / item.size;
+      haveRatio = true;
+    }
+    if (item.weight != ratio * item.size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Computes cells [lo, hi) of the row after an egg from the row before it.
+template <class Cell>
+void relaxStripe(const Cell *curr, Cell *next, uint64_t lo, uint64_t hi,
+                 uint64_t size, uint64_t weight) {
+  uint64_t from = std::max(lo, std::min(hi, size));
+  std::copy(curr + lo, curr + from, next + lo);
+  if (from < hi) {
+    relaxRow(next + from, curr + from, curr + from - size, hi - from, weight);
+  }
+}
+
+// Where stripe s of `stripes` starts when a row of N cells is split into
+// stripes of equal work for an egg of `size`: cells below the size are only
+// copied, which costs a fraction of relaxing one. Stripe `stripes` starts
+// at N.
+uint64_t balancedBound(uint64_t N, uint64_t size, uint64_t stripes,
+                       uint64_t s) {
+  const uint64_t copiesPerRelax = 4;
+
+  uint64_t from = std::min(N, size);
+  uint64_t work = (from + (N - from) * copiesPerRelax) * s / stripes;
+  return work <= from ? work : from + (work - from) / copiesPerRelax;
+}
+
+uint64_t nanosSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Time every stripe of the threaded sweeps spent on cells, and time it
+// spent waiting for the slowest stripe of the same egg.
+struct SweepLoad {
+  // Adds one egg, where stripe s took busy[s].
+  void addEgg(std::vector<uint64_t> const &busy) {
+    uint64_t span = *std::max_element(busy.begin(), busy.end());
+    for (size_t s = 0; s < busy.size(); s++) {
+      addStripe(s, busy[s], span - busy[s]);
+    }
+  }
+
+  void addStripe(size_t s, uint64_t busy, uint64_t idle) {
+    if (busyNanos.size() <= s) {
+      busyNanos.resize(s + 1, 0);
+      idleNanos.resize(s + 1, 0);
+    }
+    busyNanos[s] += busy;
+    idleNanos[s] += idle;
+  }
+
+  std::vector<uint64_t> busyNanos;
+  std::vector<uint64_t> idleNanos;
+};
+
+// Computes a single knapsack row: after sweep(), row[c] is the best weight
+// of items [first, last) that fits in capacity c.
+template <class Cell>
+class RowSweeper {
+ public:
+  virtual ~RowSweeper() = default;
+
+  void sweep(std::vector<PackItem> const &items, size_t first, size_t last,
+             std::vector<Cell> &row) {
+    std::fill(row.begin(), row.end(), 0);
+    extend(items, first, last, row);
+  }
+
+  // Adds items [first, last) to a row that already holds the best weights
+  // of earlier eggs.
+  virtual void extend(std::vector<PackItem> const &items, size_t first,
+                      size_t last, std::vector<Cell> &row) = 0;
+};
+
+template <class Cell>
+class SequentialSweeper : public RowSweeper<Cell> {
+ public:
+  virtual void extend(std::vector<PackItem> const &items, size_t first,
+                      size_t last, std::vector<Cell> &row) {
+    for (size_t i = first; i < last; i++) {
+      uint64_t size = items[i].size, weight = items[i].weight;
+      if (size < row.size()) {
+        relaxRow(row.data() + size, row.data() + size, row.data(),
+                 row.size() - size, weight);
+      }
+    }
+  }
+};
+
+// Splits every row into one stripe per shaman and waits for all stripes
+// before moving to the next egg. Stripes are re-cut for every egg by
+// balancedBound(), so that the stripes below the egg size are wider.
+template <class Cell>
+class StripedSweeper : public RowSweeper<Cell> {
+ public:
+  StripedSweeper(ThreadPool &councilArg, uint64_t numberOfShamansArg,
+                 SweepLoad *loadArg = nullptr)
+      : council(councilArg),
+        numberOfShamans(numberOfShamansArg),
+        load(loadArg) {}
+
+  virtual void extend(std::vector<PackItem> const &items, size_t first,
+                      size_t last, std::vector<Cell> &row) {
+    const uint64_t threshold = 20;
+
+    uint64_t N = row.size();
+    uint64_t interval = std::max(N / numberOfShamans + 1, threshold);
+    if (interval >= N) {
+      SequentialSweeper<Cell>().extend(items, first, last, row);
+      return;
+    }
+    uint64_t stripes = (N + interval - 1) / interval;
+
+    std::vector<Cell> next(N);
+    std::vector<uint64_t> busy(stripes);
+
+    for (size_t i = first; i < last; i++) {
+      uint64_t size = items[i].size, weight = items[i].weight;
+
+      std::vector<std::future<uint64_t>> results;
+      for (uint64_t s = 0; s < stripes; s++) {
+        uint64_t lo = balancedBound(N, size, stripes, s);
+        uint64_t hi = balancedBound(N, size, stripes, s + 1);
+        results.emplace_back(
+            council.enqueue([lo, hi, size, weight, &row, &next] {
+              auto start = std::chrono::steady_clock::now();
+              relaxStripe(row.data(), next.data(), lo, hi, size, weight);
+              return nanosSince(start);
+            }));
+      }
+
+      for (uint64_t s = 0; s < stripes; s++) {
+        busy[s] = results[s].get();
+      }
+      if (load != nullptr) {
+        load->addEgg(busy);
+      }
+      row.swap(next);
+    }
+  }
+
+ private:
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+  SweepLoad *load;
+};
+
+// Sense-reversing barrier. Threads spin on a shared flag instead of
+// sleeping on a condition variable, yielding so that it stays usable when
+// there are more threads than cores.
+class SpinBarrier {
+ public:
+  explicit SpinBarrier(uint64_t countArg)
+      : count(countArg), waiting(0), sense(false) {}
+
+  // `localSense` is owned by the calling thread and starts as false.
+  void wait(bool &localSense) {
+    localSense = !localSense;
+    if (waiting.fetch_add(1) + 1 == count) {
+      waiting.store(0);
+      sense.store(localSense);
+    } else {
+      while (sense.load() != localSense) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+ private:
+  const uint64_t count;
+  std::atomic<uint64_t> waiting;
+  std::atomic<bool> sense;
+};
+
+// Every shaman owns one stripe for the whole sweep and moves from one egg to
+// the next through a SpinBarrier, so no task is created per egg. Rows
+// alternate between two buffers: egg i reads buffer i % 2 and writes the
+// other one, which makes a single barrier per egg enough.
+//
+// All stripes must run at once, so the council has to be idle and sweep()
+// must not be called from one of its threads.
+template <class Cell>
+class BarrierSweeper : public RowSweeper<Cell> {
+ public:
+  BarrierSweeper(ThreadPool &councilArg, uint64_t numberOfShamansArg,
+                 SweepLoad *loadArg = nullptr)
+      : council(councilArg),
+        numberOfShamans(numberOfShamansArg),
+        load(loadArg) {}
+
+  virtual void extend(std::vector<PackItem> const &items, size_t first,
+                      size_t last, std::vector<Cell> &row) {
+    const uint64_t threshold = 20;
+
+    uint64_t N = row.size();
+    uint64_t interval = std::max(N / numberOfShamans + 1, threshold);
+    if (interval >= N) {
+      SequentialSweeper<Cell>().extend(items, first, last, row);
+      return;
+    }
+    uint64_t stripes = (N + interval - 1) / interval;
+
+    std::vector<Cell> next(N);
+    std::vector<Cell> *rows[2] = {&row, &next};
+    SpinBarrier barrier(stripes);
+
+    // Every stripe cuts its own bounds for each egg with balancedBound()
+    // and reports the time spent on cells and at the barrier.
+    std::vector<std::future<std::pair<uint64_t, uint64_t>>> results;
+    for (uint64_t s = 0; s < stripes; s++) {
+      results.emplace_back(council.enqueue(
+          [s, stripes, N, first, last, &items, &rows, &barrier] {
+            std::pair<uint64_t, uint64_t> time(0, 0);
+            bool localSense = false;
+            for (size_t i = first; i < last; i++) {
+              uint64_t size = items[i].size, weight = items[i].weight;
+              auto start = std::chrono::steady_clock::now();
+              relaxStripe(rows[(i - first) % 2]->data(),
+                          rows[(i - first + 1) % 2]->data(),
+                          balancedBound(N, size, stripes, s),
+                          balancedBound(N, size, stripes, s + 1), size,
+                          weight);
+              time.first += nanosSince(start);
+              start = std::chrono::steady_clock::now();
+              barrier.wait(localSense);
+              time.second += nanosSince(start);
+            }
+            return time;
+          }));
+    }
+
+    for (uint64_t s = 0; s < stripes; s++) {
+      std::pair<uint64_t, uint64_t> time = results[s].get();
+      if (load != nullptr) {
+        load->addStripe(s, time.first, time.second);
+      }
+    }
+    if ((last - first) % 2 == 1) {
+      row.swap(next);
+    }
+  }
+
+ private:
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+  SweepLoad *load;
+};
+
+// Processes a block of eggs over a cache-sized block of capacities before
+// moving on, so that a wide row is streamed through memory once per block of
+// eggs instead of once per egg.
+//
+// Tile (b, k) covers eggs [b * B, b * B + B) and capacities [k * W, k * W + W)
+// with W at least the largest egg size, so it only reads tiles (b - 1, k - 1),
+// (b - 1, k) and (b, k - 1). Intermediate rows of a block live in a ring of
+// two tile widths and only the last row of each block is written to one of
+// two shared rows; the wavefront keeps a ring per block in flight, which
+// adds up to about B rows. Tiles on the same skewed diagonal 2 * b + k are
+// independent; shamans run them in parallel with a SpinBarrier between
+// diagonals. Without a council the tiles are run block by block.
+template <class Cell>
+class TiledSweeper : public RowSweeper<Cell> {
+ public:
+  TiledSweeper(ThreadPool *councilArg, uint64_t numberOfShamansArg)
+      : council(councilArg), numberOfShamans(numberOfShamansArg) {}
+
+  virtual void extend(std::vector<PackItem> const &items, size_t first,
+                      size_t last, std::vector<Cell> &row) {
+    const uint64_t eggsPerBlock = 8;
+    const uint64_t tileWidth = 2048;
+
+    uint64_t N = row.size();
+    uint64_t width = tileWidth;
+    for (size_t i = first; i < last; i++) {
+      width = std::max(width, std::min(items[i].size, N));
+    }
+    if (first == last || width >= N) {
+      SequentialSweeper<Cell>().extend(items, first, last, row);
+      return;
+    }
+
+    Tiling tiling;
+    tiling.items = &items;
+    tiling.initial = row.data();
+    tiling.first = first;
+    tiling.last = last;
+    tiling.N = N;
+    tiling.B = eggsPerBlock;
+    tiling.W = width;
+    tiling.blocks = (last - first + eggsPerBlock - 1) / eggsPerBlock;
+    tiling.K = (N + width - 1) / width;
+    tiling.out[0].resize(N);
+    tiling.out[1].resize(N);
+    bool wavefront = council != nullptr && numberOfShamans > 1;
+    // Up to K / 2 + 1 blocks are in flight on a wavefront, one otherwise.
+    tiling.rings.resize(wavefront ? std::min(tiling.blocks, tiling.K / 2 + 1)
+                                  : 1,
+                        std::vector<Cell>(eggsPerBlock * 2 * width));
+
+    if (!wavefront) {
+      for (uint64_t b = 0; b < tiling.blocks; b++) {
+        for (uint64_t k = 0; k < tiling.K; k++) {
+          tiling.run(b, k);
+        }
+      }
+    } else {
+      runWavefront(tiling);
+    }
+
+    row.swap(tiling.out[(tiling.blocks - 1) % 2]);
+  }
+
+ private:
+  struct Tiling {
+    void run(uint64_t b, uint64_t k) {
+      uint64_t lo = k * W, hi = std::min(N, lo + W), ring = 2 * W;
+      uint64_t offset = (k % 2) * W;
+      size_t eggFirst = first + b * B;
+      size_t count = std::min<size_t>(B, last - eggFirst);
+      Cell *rows = this->rings[b % this->rings.size()].data();
+
+      for (size_t e = 0; e < count; e++) {
+        uint64_t size = (*items)[eggFirst + e].size;
+        uint64_t weight = (*items)[eggFirst + e].weight;
+        Cell *curr = e + 1 == count ? out[b % 2].data() + lo
+                                    : rows + e * ring + offset;
+
+        // Cells [lo, lo + from) are too small for the egg.
+        uint64_t from = std::max(lo, std::min(hi, size)) - lo;
+
+        if (e == 0) {
+          // The first egg of a block reads the previous block's output.
+          const Cell *in = (b == 0 ? initial : out[(b - 1) % 2].data()) + lo;
+          std::copy(in, in + from, curr);
+          if (from < hi - lo) {
+            relaxRow(curr + from, in + from, in + from - size,
+                     hi - lo - from, weight);
+          }
+          continue;
+        }
+
+        // Cells below `split` take from the other half of the ring.
+        const Cell *prev = rows + (e - 1) * ring + offset;
+        uint64_t split =
+            std::min(hi, std::max(lo + from, lo - offset + size)) - lo;
+        std::copy(prev, prev + from, curr);
+        if (from < split) {
+          relaxRow(curr + from, prev + from, prev + from + ring - size,
+                   split - from, weight);
+        }
+        if (split < hi - lo) {
+          relaxRow(curr + split, prev + split, prev + split - size,
+                   hi - lo - split, weight);
+        }
+      }
+    }
+
+    std::vector<PackItem> const *items;
+    const Cell *initial;
+    size_t first, last;
+    uint64_t N, B, W, blocks, K;
+    std::vector<Cell> out[2];
+    std::vector<std::vector<Cell>> rings;
+  };
+
+  void runWavefront(Tiling &tiling) {
+    uint64_t diagonals = 2 * (tiling.blocks - 1) + tiling.K;
+    uint64_t workers =
+        std::min(numberOfShamans, (tiling.K + 1) / 2);
+    SpinBarrier barrier(workers);
+
+    std::vector<std::future<void>> results;
+    for (uint64_t w = 0; w < workers; w++) {
+      results.emplace_back(council->enqueue(
+          [w, workers, diagonals, &tiling, &barrier] {
+            bool localSense = false;
+            for (uint64_t d = 0; d < diagonals; d++) {
+              uint64_t bFirst = d < tiling.K ? 0 : (d - tiling.K) / 2 + 1;
+              uint64_t bLast = std::min(tiling.blocks - 1, d / 2);
+              for (uint64_t b = bFirst + w; b <= bLast; b += workers) {
+                tiling.run(b, d - 2 * b);
+              }
+              barrier.wait(localSense);
+            }
+          }));
+    }
+
+    for (auto &&result : results) {
+      result.get();
+    }
+  }
+
+  ThreadPool *council;
+  uint64_t numberOfShamans;
+};
+
+// Knapsack in O(capacity) memory. The egg list is halved, both halves are
+// swept with rolling rows and the capacity split that maximizes the sum of
+// the two rows tells how much room each half gets; recursing on both halves
+// recovers the exact set of chosen eggs.
+template <class Cell>
+class RollingRowPacker {
+ public:
+  explicit RollingRowPacker(RowSweeper<Cell> &sweeperArg)
+      : sweeper(sweeperArg) {}
+
+  Packing pack(std::vector<PackItem> const &items, uint64_t capacity) {
+    Packing packing;
+    solve(items, 0, items.size(), capacity, packing);
+    std::sort(packing.chosen.begin(), packing.chosen.end());
+    return packing;
+  }
+
+ private:
+  void solve(std::vector<PackItem> const &items, size_t first, size_t last,
+             uint64_t capacity, Packing &packing) {
+    // Compared against the room left, so huge sizes cannot wrap around.
+    bool fits = true;
+    uint64_t totalSize = 0;
+    for (size_t i = first; i < last && fits; i++) {
+      fits = items[i].size <= capacity - totalSize;
+      totalSize += fits ? items[i].size : 0;
+    }
+    if (last - first == 1 || fits) {
+      for (size_t i = first; i < last; i++) {
+        if (items[i].size <= capacity && items[i].weight > 0) {
+          packing.weight += items[i].weight;
+          packing.chosen.push_back(i);
+        }
+      }
+      return;
+    }
+
+    size_t mid = first + (last - first) / 2;
+    uint64_t split = 0;
+    {
+      std::vector<Cell> front(capacity + 1), back(capacity + 1);
+      sweeper.sweep(items, first, mid, front);
+      sweeper.sweep(items, mid, last, back);
+      for (uint64_t c = 0; c <= capacity; c++) {
+        if (front[c] + back[capacity - c] >
+            front[split] + back[capacity - split]) {
+          split = c;
+        }
+      }
+    }
+
+    solve(items, first, mid, split, packing);
+    solve(items, mid, last, capacity - split, packing);
+  }
+
+  RowSweeper<Cell> &sweeper;
+};
+
+// Subset sums as a bitset, 64 capacities per word: for every egg
+// reach |= reach << size. With a council the words are split into stripes
+// owned by one shaman each, synchronized with a SpinBarrier per egg.
+class BitsetSweeper {
+ public:
+  BitsetSweeper(ThreadPool *councilArg, uint64_t numberOfShamansArg)
+      : council(councilArg), numberOfShamans(numberOfShamansArg) {}
+
+  // After sweep(), bit c of `reach` tells whether some subset of items
+  // [first, last) has total size exactly c.
+  void sweep(std::vector<PackItem> const &items, size_t first, size_t last,
+             std::vector<uint64_t> &reach) {
+    const uint64_t threshold = 16;
+
+    uint64_t W = reach.size();
+    std::fill(reach.begin(), reach.end(), 0);
+    if (W == 0) {
+      return;
+    }
+    reach[0] = 1;
+
+    uint64_t interval = std::max(W / numberOfShamans + 1, threshold);
+    if (council == nullptr || interval >= W) {
+      // Going from the highest word down only reads words not updated yet.
+      for (size_t i = first; i < last; i++) {
+        if (items[i].size == 0) {
+          continue;
+        }
+        for (uint64_t w = W; w-- > 0;) {
+          reach[w] |= shiftedWord(reach.data(), w, items[i].size);
+        }
+      }
+      return;
+    }
+
+    std::vector<uint64_t> next(W);
+    std::vector<uint64_t> *words[2] = {&reach, &next};
+    SpinBarrier barrier((W + interval - 1) / interval);
+
+    std::vector<std::future<void>> results;
+    for (uint64_t lo = 0; lo < W; lo += interval) {
+      uint64_t hi = std::min(W, lo + interval);
+      results.emplace_back(council->enqueue(
+          [lo, hi, first, last, &items, &words, &barrier] {
+            bool localSense = false;
+            for (size_t i = first; i < last; i++) {
+              const uint64_t *curr = words[(i - first) % 2]->data();
+              uint64_t *next = words[(i - first + 1) % 2]->data();
+              for (uint64_t w = lo; w < hi; w++) {
+                next[w] = curr[w] | shiftedWord(curr, w, items[i].size);
+              }
+              barrier.wait(localSense);
+            }
+          }));
+    }
+
+    for (auto &&result : results) {
+      result.get();
+    }
+    if ((last - first) % 2 == 1) {
+      reach.swap(next);
+    }
+  }
+
+  static bool test(std::vector<uint64_t> const &bits, uint64_t c) {
+    return (bits[c / 64] >> (c % 64)) & 1;
+  }
+
+ private:
+  // Word `w` of the bitset shifted left by `size` bits.
+  static uint64_t shiftedWord(const uint64_t *bits, uint64_t w,
+                              uint64_t size) {
+    uint64_t q = size / 64, r = size % 64;
+    if (w < q) {
+      return 0;
+    }
+    uint64_t word = bits[w - q] << r;
+    if (r != 0 && w > q) {
+      word |= bits[w - q - 1] >> (64 - r);
+    }
+    return word;
+  }
+
+  ThreadPool *council;
+  uint64_t numberOfShamans;
+};
+
+// Fill-the-bag packing over bitsets, for eggs that pass isSubsetSum(): the
+// fullest reachable size is found with one sweep, then the egg list is
+// halved recursively like in RollingRowPacker, splitting the target size
+// between the halves.
+class SubsetSumPacker {
+ public:
+  explicit SubsetSumPacker(BitsetSweeper &sweeperArg) : sweeper(sweeperArg) {}
+
+  Packing pack(std::vector<PackItem> const &items, uint64_t capacity) {
+    capacity = std::min(capacity, totalSize(items));
+
+    uint64_t target = 0;
+    {
+      std::vector<uint64_t> reach(capacity / 64 + 1);
+      sweeper.sweep(items, 0, items.size(), reach);
+      for (target = capacity; !BitsetSweeper::test(reach, target);) {
+        target--;
+      }
+    }
+
+    Packing packing;
+    solve(items, 0, items.size(), target, packing);
+    std::sort(packing.chosen.begin(), packing.chosen.end());
+    for (auto index : packing.chosen) {
+      packing.weight += items[index].weight;
+    }
+    return packing;
+  }
+
+ private:
+  void solve(std::vector<PackItem> const &items, size_t first, size_t last,
+             uint64_t target, Packing &packing) {
+    if (target == 0) {
+      return;
+    }
+    if (last - first == 1) {
+      packing.chosen.push_back(first);
+      return;
+    }
+
+    size_t mid = first + (last - first) / 2;
+    uint64_t split = 0;
+    {
+      std::vector<uint64_t> front(target / 64 + 1), back(target / 64 + 1);
+      sweeper.sweep(items, first, mid, front);
+      sweeper.sweep(items, mid, last, back);
+      while (!BitsetSweeper::test(front, split) ||
+             !BitsetSweeper::test(back, target - split)) {
+        split++;
+      }
+    }
+
+    solve(items, first, mid, split, packing);
+    solve(items, mid, last, target - split, packing);
+  }
+
+  BitsetSweeper &sweeper;
+};
+
+#endif  // SRC_KNAPSACK_H_
@@ -0,0 +1,204 @@
+#ifndef SRC_MEET_IN_THE_MIDDLE_H_
+#define SRC_MEET_IN_THE_MIDDLE_H_
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "knapsack.h"
+
+// A subset of one half of the eggs, ordered by size, with the subsets that
+// do not fit in the bag last.
+struct HalfSubset {
+  uint64_t size;
+  uint64_t weight;
+  uint64_t mask;
+  bool overfull;
+
+  bool operator<(HalfSubset const &other) const {
+    if (overfull != other.overfull) {
+      return other.overfull;
+    }
+    return size < other.size;
+  }
+};
+
+// Exact knapsack for a few eggs and any capacity. Subset sums of both
+// halves of the egg list are enumerated in parallel and sorted; a monotone
+// two-pointer sweep over the sorted halves, split between the shamans,
+// finds the best pair. O(2^(M/2)) work and no capacity-sized allocation,
+// but the two halves take 2^(M/2) subsets each.
+class MeetInTheMiddlePacker {
+ public:
+  typedef std::vector<HalfSubset>::iterator Iterator;
+  typedef std::function<void(Iterator, Iterator)> Sorter;
+
+  // Twice 2^20 subsets of 32 bytes.
+  static const size_t maxEggs = 40;
+
+  MeetInTheMiddlePacker(ThreadPool &councilArg, uint64_t numberOfShamansArg,
+                        Sorter sorterArg)
+      : council(councilArg),
+        numberOfShamans(numberOfShamansArg),
+        sorter(sorterArg) {}
+
+  // Eggs that can never be packed do not count against maxEggs.
+  static std::vector<size_t> usefulEggs(std::vector<PackItem> const &items,
+                                        uint64_t capacity) {
+    std::vector<size_t> useful;
+    for (size_t i = 0; i < items.size(); i++) {
+      if (items[i].size <= capacity && items[i].weight > 0) {
+        useful.push_back(i);
+      }
+    }
+    return useful;
+  }
+
+  Packing pack(std::vector<PackItem> const &items, uint64_t capacity) {
+    std::vector<size_t> useful = usefulEggs(items, capacity);
+    size_t half = useful.size() / 2;
+    std::vector<size_t> frontEggs(useful.begin(), useful.begin() + half);
+    std::vector<size_t> backEggs(useful.begin() + half, useful.end());
+
+    std::vector<HalfSubset> front = enumerate(items, frontEggs, capacity);
+    std::vector<HalfSubset> back = enumerate(items, backEggs, capacity);
+    sorter(front.begin(), front.end());
+    sorter(back.begin(), back.end());
+
+    // back[j] becomes the heaviest subset among back[0..j].
+    for (size_t j = 1; j < back.size(); j++) {
+      if (back[j].weight < back[j - 1].weight) {
+        back[j].weight = back[j - 1].weight;
+        back[j].mask = back[j - 1].mask;
+      }
+    }
+
+    std::pair<uint64_t, uint64_t> best = bestPair(front, back, capacity);
+
+    Packing packing;
+    packing.weight = addWeights(front[best.first], back[best.second]);
+    for (size_t e = 0; e < frontEggs.size(); e++) {
+      if ((front[best.first].mask >> e) & 1) {
+        packing.chosen.push_back(frontEggs[e]);
+      }
+    }
+    for (size_t e = 0; e < backEggs.size(); e++) {
+      if ((back[best.second].mask >> e) & 1) {
+        packing.chosen.push_back(backEggs[e]);
+      }
+    }
+    std::sort(packing.chosen.begin(), packing.chosen.end());
+    return packing;
+  }
+
+ private:
+  // All 2^n subsets of `eggs`; the ones over `capacity` are overfull and
+  // weights saturate at UINT64_MAX. Shamans take aligned chunks of masks,
+  // and within a chunk every subset extends the one without its lowest egg.
+  std::vector<HalfSubset> enumerate(std::vector<PackItem> const &items,
+                                    std::vector<size_t> const &eggs,
+                                    uint64_t capacity) {
+    uint64_t count = 1ULL << eggs.size();
+    uint64_t chunk = count;
+    while (chunk > 1 && count / chunk < numberOfShamans) {
+      chunk /= 2;
+    }
+
+    std::vector<HalfSubset> subsets(count);
+    std::vector<std::future<void>> results;
+    for (uint64_t lo = 0; lo < count; lo += chunk) {
+      results.emplace_back(council.enqueue(
+          [lo, chunk, capacity, &items, &eggs, &subsets] {
+            subsets[lo] = {0, 0, lo, false};
+            for (size_t e = 0; e < eggs.size(); e++) {
+              if ((lo >> e) & 1) {
+                subsets[lo] = extend(subsets[lo], items[eggs[e]], e, capacity);
+              }
+            }
+            for (uint64_t l = 1; l < chunk; l++) {
+              uint64_t e = __builtin_ctzll(l);
+              subsets[lo + l] = extend(subsets[lo + (l & (l - 1))],
+                                       items[eggs[e]], e, capacity);
+            }
+          }));
+    }
+
+    for (auto &&result : results) {
+      result.get();
+    }
+    return subsets;
+  }
+
+  static HalfSubset extend(HalfSubset subset, PackItem const &item, size_t e,
+                           uint64_t capacity) {
+    if (subset.overfull || item.size > capacity - subset.size) {
+      subset.overfull = true;
+    } else {
+      subset.size += item.size;
+    }
+    subset.weight = item.weight > UINT64_MAX - subset.weight
+                        ? UINT64_MAX
+                        : subset.weight + item.weight;
+    subset.mask |= 1ULL << e;
+    return subset;
+  }
+
+  // Weight of two fitting subsets together, saturated like their own.
+  static uint64_t addWeights(HalfSubset const &a, HalfSubset const &b) {
+    return b.weight > UINT64_MAX - a.weight ? UINT64_MAX : a.weight + b.weight;
+  }
+
+  // Indices of the heaviest fitting pair. `back` holds prefix maxima, so
+  // for every front subset the best partner is the last back subset that
+  // still fits; it only moves down as front subsets grow. Every shaman
+  // sweeps a slice of `front` starting from a binary search.
+  std::pair<uint64_t, uint64_t> bestPair(std::vector<HalfSubset> const &front,
+                                         std::vector<HalfSubset> const &back,
+                                         uint64_t capacity) {
+    uint64_t interval = front.size() / numberOfShamans + 1;
+
+    std::vector<std::future<std::pair<uint64_t, uint64_t>>> results;
+    for (uint64_t lo = 0; lo < front.size(); lo += interval) {
+      uint64_t hi = std::min<uint64_t>(front.size(), lo + interval);
+      results.emplace_back(council.enqueue([lo, hi, capacity, &front, &back] {
+        std::pair<uint64_t, uint64_t> best(0, 0);
+        uint64_t bestWeight = 0;
+        if (front[lo].overfull) {
+          return best;
+        }
+        HalfSubset room = {capacity - front[lo].size, 0, 0, false};
+        uint64_t j =
+            std::upper_bound(back.begin(), back.end(), room) - back.begin() -
+            1;
+        for (uint64_t i = lo; i < hi && !front[i].overfull; i++) {
+          while (back[j].size > capacity - front[i].size) {
+            j--;
+          }
+          if (addWeights(front[i], back[j]) > bestWeight) {
+            bestWeight = addWeights(front[i], back[j]);
+            best = {i, j};
+          }
+        }
+        return best;
+      }));
+    }
+
+    std::pair<uint64_t, uint64_t> best(0, 0);
+    for (auto &&result : results) {
+      std::pair<uint64_t, uint64_t> candidate = result.get();
+      if (addWeights(front[candidate.first], back[candidate.second]) >
+          addWeights(front[best.first], back[best.second])) {
+        best = candidate;
+      }
+    }
+    return best;
+  }
+
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+  Sorter sorter;
+};
+
+#endif  // SRC_MEET_IN_THE_MIDDLE_H_
@@ -0,0 +1,163 @@
+#ifndef SRC_MERGE_SORT_H_
+#define SRC_MERGE_SORT_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "frugal_sort.h"
+
+// Number of elements of `a` among the first k of the stable merge of a and
+// b, where an element of `a` goes before an equal one of `b`. This is where
+// the merge path crosses diagonal k.
+template <class Iterator>
+uint64_t coRank(uint64_t k, Iterator a, uint64_t aSize, Iterator b,
+                uint64_t bSize) {
+  uint64_t lo = k > bSize ? k - bSize : 0, hi = std::min(k, aSize);
+  while (lo < hi) {
+    uint64_t i = lo + (hi - lo) / 2;
+    if (!(*(b + (k - i - 1)) < *(a + i))) {
+      lo = i + 1;
+    } else {
+      hi = i;
+    }
+  }
+  return lo;
+}
+
+// Parallel merge sort. The vector is cut into one run per shaman and the
+// runs are sorted at once; then pairs of runs are merged level by level,
+// back and forth between the vector and a scratch buffer that is kept
+// across calls. Every level is split into equal slices of the output, one
+// per shaman, and coRank() tells where each slice starts in both runs, so
+// the work stays even however the values are distributed.
+//
+// With `stable`, runs are sorted by std::stable_sort and merges prefer the
+// left run, so equal elements keep their order. A `frugal` sorter sorts
+// runs by frugalSort() and merges by gallopMerge() instead, which is always
+// stable and calls operator< close to the fewest times a comparison sort
+// can: worth it when comparing costs much more than moving.
+//
+// Must be called from outside the council.
+template <class T>
+class MergeSorter {
+ public:
+  MergeSorter(ThreadPool &councilArg, uint64_t numberOfShamansArg,
+              bool frugalArg = false)
+      : council(councilArg),
+        numberOfShamans(numberOfShamansArg),
+        frugal(frugalArg) {}
+
+  void sort(std::vector<T> &values, bool stable) {
+    const uint64_t threshold = 1024;
+
+    uint64_t n = values.size();
+    uint64_t runs = std::min(numberOfShamans, n / threshold + 1);
+    scratch.resize(n);
+    if (runs <= 1) {
+      sortRun(values, 0, n, stable);
+      return;
+    }
+
+    std::vector<uint64_t> bounds;
+    for (uint64_t r = 0; r <= runs; r++) {
+      bounds.push_back(n * r / runs);
+    }
+    {
+      std::vector<std::future<void>> results;
+      for (uint64_t r = 0; r < runs; r++) {
+        uint64_t lo = bounds[r], hi = bounds[r + 1];
+        results.emplace_back(council.enqueue([this, &values, lo, hi, stable] {
+          sortRun(values, lo, hi, stable);
+        }));
+      }
+      for (auto &&result : results) {
+        result.get();
+      }
+    }
+
+    std::vector<T> *from = &values, *to = &scratch;
+    while (bounds.size() > 2) {
+      mergeLevel(*from, *to, bounds);
+      std::vector<uint64_t> merged;
+      for (size_t r = 0; r < bounds.size(); r += 2) {
+        merged.push_back(bounds[r]);
+      }
+      if (merged.back() != n) {
+        merged.push_back(n);
+      }
+      bounds.swap(merged);
+      std::swap(from, to);
+    }
+    if (from != &values) {
+      values.swap(scratch);
+    }
+  }
+
+ private:
+  // Sorts cells [lo, hi) of `values`; a frugal sort borrows the same cells
+  // of `scratch`.
+  void sortRun(std::vector<T> &values, uint64_t lo, uint64_t hi,
+               bool stable) {
+    auto first = values.begin() + lo, last = values.begin() + hi;
+    if (frugal) {
+      frugalSort(first, last, scratch.begin() + lo);
+    } else if (stable) {
+      std::stable_sort(first, last);
+    } else {
+      std::sort(first, last);
+    }
+  }
+
+  // Merges runs 2r and 2r + 1 of `from` into `to` for every r; a last run
+  // without a partner is copied.
+  void mergeLevel(std::vector<T> const &from, std::vector<T> &to,
+                  std::vector<uint64_t> const &bounds) {
+    uint64_t n = from.size();
+    std::vector<std::future<void>> results;
+    for (uint64_t s = 0; s < numberOfShamans; s++) {
+      uint64_t lo = n * s / numberOfShamans;
+      uint64_t hi = n * (s + 1) / numberOfShamans;
+      results.emplace_back(
+          council.enqueue([this, lo, hi, &from, &to, &bounds] {
+            mergeSlice(from, to, bounds, lo, hi);
+          }));
+    }
+    for (auto &&result : results) {
+      result.get();
+    }
+  }
+
+  // Output cells [lo, hi) of a level, which may cross several merges.
+  void mergeSlice(std::vector<T> const &from, std::vector<T> &to,
+                  std::vector<uint64_t> const &bounds, uint64_t lo,
+                  uint64_t hi) {
+    size_t r = std::upper_bound(bounds.begin(), bounds.end(), lo) -
+               bounds.begin() - 1;
+    r -= r % 2;
+    while (lo < hi) {
+      uint64_t first = bounds[r], mid = bounds[r + 1];
+      uint64_t last = r + 2 < bounds.size() ? bounds[r + 2] : mid;
+      uint64_t end = std::min(hi, last);
+      auto a = from.begin() + first, b = from.begin() + mid;
+      uint64_t i0 = coRank(lo - first, a, mid - first, b, last - mid);
+      uint64_t i1 = coRank(end - first, a, mid - first, b, last - mid);
+      uint64_t j0 = lo - first - i0, j1 = end - first - i1;
+      if (frugal) {
+        gallopMerge(a + i0, a + i1, b + j0, b + j1, to.begin() + lo);
+      } else {
+        std::merge(a + i0, a + i1, b + j0, b + j1, to.begin() + lo);
+      }
+      lo = end;
+      r += 2;
+    }
+  }
+
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+  bool frugal;
+  std::vector<T> scratch;
+};
+
+#endif  // SRC_MERGE_SORT_H_
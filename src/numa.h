@@ -0,0 +1,224 @@
+#ifndef SRC_NUMA_H_
+#define SRC_NUMA_H_
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#define SHAMANS_NUMA_AFFINITY
+#endif
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "knapsack.h"
+
+// CPUs of every NUMA node that has any, as listed in sysfs. Without sysfs the
+// machine looks like a single node. detect() reads a file per online node,
+// so callers keep the result rather than detecting again.
+class NumaTopology {
+ public:
+  explicit NumaTopology(std::vector<std::vector<int>> cpusArg)
+      : cpusOfNode(cpusArg) {}
+
+  static NumaTopology detect() {
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string nodes;
+    if (!online || !std::getline(online, nodes)) {
+      return NumaTopology(std::vector<std::vector<int>>());
+    }
+
+    std::vector<std::vector<int>> cpus;
+    for (int node : parseCpuList(nodes)) {
+      std::ifstream cpulist("/sys/devices/system/node/node" +
+                            std::to_string(node) + "/cpulist");
+      std::string line;
+      if (cpulist && std::getline(cpulist, line)) {
+        std::vector<int> nodeCpus = parseCpuList(line);
+        if (!nodeCpus.empty()) {
+          cpus.push_back(nodeCpus);
+        }
+      }
+    }
+    return NumaTopology(cpus);
+  }
+
+  size_t nodes() const { return cpusOfNode.size(); }
+
+  std::vector<int> const &cpus(size_t node) const { return cpusOfNode[node]; }
+
+ private:
+  // "0-3,8,10-11" lists CPUs 0, 1, 2, 3, 8, 10 and 11; node lists read
+  // the same.
+  static std::vector<int> parseCpuList(std::string const &line) {
+    std::vector<int> cpus;
+    std::stringstream ranges(line);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+      int first = 0, last = 0;
+      char dash = 0;
+      std::stringstream bounds(range);
+      if (!(bounds >> first)) {
+        continue;
+      }
+      last = first;
+      if (bounds >> dash >> last && dash != '-') {
+        continue;
+      }
+      for (int cpu = first; cpu <= last; cpu++) {
+        cpus.push_back(cpu);
+      }
+    }
+    return cpus;
+  }
+
+  std::vector<std::vector<int>> cpusOfNode;
+};
+
+// Pins the calling thread to `cpus` and restores its previous affinity when
+// it goes out of scope. Does nothing where affinity cannot be set.
+class NodeAffinity {
+ public:
+  explicit NodeAffinity(std::vector<int> const &cpus) : pinned(false) {
+#ifdef SHAMANS_NUMA_AFFINITY
+    cpu_set_t wanted;
+    CPU_ZERO(&wanted);
+    for (int cpu : cpus) {
+      if (cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &wanted);
+      }
+    }
+    pthread_t self = pthread_self();
+    pinned = pthread_getaffinity_np(self, sizeof(previous), &previous) == 0 &&
+             pthread_setaffinity_np(self, sizeof(wanted), &wanted) == 0;
+#else
+    (void)cpus;
+#endif
+  }
+
+  ~NodeAffinity() {
+#ifdef SHAMANS_NUMA_AFFINITY
+    if (pinned) {
+      pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+    }
+#endif
+  }
+
+  NodeAffinity(NodeAffinity const &) = delete;
+  NodeAffinity &operator=(NodeAffinity const &) = delete;
+
+ private:
+  bool pinned;
+#ifdef SHAMANS_NUMA_AFFINITY
+  cpu_set_t previous;
+#endif
+};
+
+// BarrierSweeper for machines with several NUMA nodes. Every stripe lives in
+// buffers that its shaman allocates and first-touches, so their pages land on
+// the shaman's node, and the shaman is pinned to that node for the whole
+// sweep. Stripes keep their bounds across eggs; a stripe reads another one
+// only for the `size`-wide halo below its own cells. With a single node it
+// is a plain BarrierSweeper.
+//
+// Like BarrierSweeper, all stripes must run at once.
+template <class Cell>
+class NumaSweeper : public RowSweeper<Cell> {
+ public:
+  NumaSweeper(ThreadPool &councilArg, uint64_t numberOfShamansArg,
+              NumaTopology topologyArg = NumaTopology::detect(),
+              SweepLoad *loadArg = nullptr)
+      : council(councilArg),
+        numberOfShamans(numberOfShamansArg),
+        topology(topologyArg),
+        load(loadArg) {}
+
+  virtual void extend(std::vector<PackItem> const &items, size_t first,
+                      size_t last, std::vector<Cell> &row) {
+    const uint64_t threshold = 20;
+
+    uint64_t N = row.size();
+    uint64_t interval = std::max(N / numberOfShamans + 1, threshold);
+    if (topology.nodes() < 2 || interval >= N) {
+      BarrierSweeper<Cell>(council, numberOfShamans, load)
+          .extend(items, first, last, row);
+      return;
+    }
+    uint64_t stripes = (N + interval - 1) / interval;
+
+    // stripe[b][s] is buffer b of stripe s; egg i reads buffer i % 2.
+    std::vector<std::vector<Cell>> stripe[2];
+    stripe[0].resize(stripes);
+    stripe[1].resize(stripes);
+    SpinBarrier barrier(stripes);
+
+    std::vector<std::future<std::pair<uint64_t, uint64_t>>> results;
+    for (uint64_t s = 0; s < stripes; s++) {
+      size_t node = s * topology.nodes() / stripes;
+      results.emplace_back(council.enqueue(
+          [this, s, node, N, interval, first, last, &items, &row, &stripe,
+           &barrier] {
+            NodeAffinity affinity(topology.cpus(node));
+            uint64_t lo = s * interval, hi = std::min(N, lo + interval);
+            stripe[0][s].assign(row.begin() + lo, row.begin() + hi);
+            stripe[1][s].resize(hi - lo);
+
+            std::pair<uint64_t, uint64_t> time(0, 0);
+            bool localSense = false;
+            barrier.wait(localSense);
+            for (size_t i = first; i < last; i++) {
+              auto start = std::chrono::steady_clock::now();
+              relaxOwned(stripe[(i - first) % 2],
+                         stripe[(i - first + 1) % 2][s].data(), s, interval,
+                         hi, items[i]);
+              time.first += nanosSince(start);
+              start = std::chrono::steady_clock::now();
+              barrier.wait(localSense);
+              time.second += nanosSince(start);
+            }
+            std::copy(stripe[(last - first) % 2][s].begin(),
+                      stripe[(last - first) % 2][s].end(), row.begin() + lo);
+            return time;
+          }));
+    }
+
+    for (uint64_t s = 0; s < stripes; s++) {
+      std::pair<uint64_t, uint64_t> time = results[s].get();
+      if (load != nullptr) {
+        load->addStripe(s, time.first, time.second);
+      }
+    }
+  }
+
+ private:
+  // Cells of stripe s after `item`. The cells an egg is taken from are cut
+  // at stripe bounds and read from the stripe that owns them.
+  static void relaxOwned(std::vector<std::vector<Cell>> const &curr,
+                         Cell *next, uint64_t s, uint64_t interval,
+                         uint64_t hi, PackItem item) {
+    uint64_t lo = s * interval;
+    uint64_t from = std::max(lo, std::min(hi, item.size));
+    const Cell *own = curr[s].data();
+    std::copy(own, own + (from - lo), next);
+    for (uint64_t c = from; c < hi;) {
+      uint64_t source = c - item.size;
+      uint64_t owner = source / interval;
+      uint64_t count = std::min(hi - c, (owner + 1) * interval - source);
+      relaxRow(next + (c - lo), own + (c - lo),
+               curr[owner].data() + (source - owner * interval), count,
+               item.weight);
+      c += count;
+    }
+  }
+
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+  NumaTopology topology;
+  SweepLoad *load;
+};
+
+#endif  // SRC_NUMA_H_
@@ -0,0 +1,79 @@
+#ifndef SRC_PACKING_STATE_H_
+#define SRC_PACKING_STATE_H_
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include "knapsack.h"
+#include "types.h"
+
+// A live knapsack row for an inventory that keeps growing. addEggs() only
+// sweeps the new eggs on top of the row, bestFor() is a lookup, and a
+// checkpoint stores the row so that a restart does not replay history.
+//
+// The sweeper works with the council and the load counters of the adventure
+// that made it, so the state must not outlive that adventure; a checkpoint
+// carries the row over to a state of a new one.
+class EggPackingState {
+ public:
+  EggPackingState(uint64_t capacityArg,
+                  std::unique_ptr<RowSweeper<uint64_t>> sweeperArg)
+      : sweeper(std::move(sweeperArg)), eggCount(0), row(capacityArg + 1, 0) {}
+
+  void addEggs(std::vector<Egg> batch) {
+    std::vector<PackItem> items = readItems(batch);
+    sweeper->extend(items, 0, items.size(), row);
+    eggCount += items.size();
+  }
+
+  // Heaviest packing of all eggs added so far into `capacity`.
+  uint64_t bestFor(uint64_t capacity) const {
+    if (capacity >= row.size()) {
+      throw std::out_of_range("capacity above the one of the state");
+    }
+    return row[capacity];
+  }
+
+  uint64_t getCapacity() const { return row.size() - 1; }
+
+  uint64_t getEggCount() const { return eggCount; }
+
+  void saveCheckpoint(std::ostream &out) const {
+    uint64_t header[3] = {checkpointMagic, eggCount, row.size()};
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(row.data()),
+              row.size() * sizeof(uint64_t));
+    if (!out) {
+      throw std::runtime_error("failed to write the packing checkpoint");
+    }
+  }
+
+  // The checkpoint has to come from a state of the same capacity.
+  void loadCheckpoint(std::istream &in) {
+    uint64_t header[3];
+    in.read(reinterpret_cast<char *>(header), sizeof(header));
+    if (!in || header[0] != checkpointMagic || header[2] != row.size()) {
+      throw std::runtime_error("not a checkpoint of this packing state");
+    }
+    std::vector<uint64_t> loaded(row.size());
+    in.read(reinterpret_cast<char *>(loaded.data()),
+            loaded.size() * sizeof(uint64_t));
+    if (!in) {
+      throw std::runtime_error("truncated packing checkpoint");
+    }
+    row.swap(loaded);
+    eggCount = header[1];
+  }
+
+ private:
+  static const uint64_t checkpointMagic = 0x31534747454b4150ULL;
+
+  std::unique_ptr<RowSweeper<uint64_t>> sweeper;
+  uint64_t eggCount;
+  std::vector<uint64_t> row;
+};
+
+#endif  // SRC_PACKING_STATE_H_
@@ -0,0 +1,138 @@
+#ifndef SRC_PARTITION_H_
+#define SRC_PARTITION_H_
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+// Pivot for parallelPartition(): every shaman takes the median of an evenly
+// spaced sample of its chunk, and the pivot is the median of those medians.
+// The pivot is always one of the elements.
+template <class Iterator>
+typename std::iterator_traits<Iterator>::value_type samplePivot(
+    ThreadPool &council, uint64_t chunks, Iterator first, Iterator last) {
+  typedef typename std::iterator_traits<Iterator>::value_type Value;
+  const uint64_t samplesPerChunk = 31;
+
+  uint64_t n = last - first;
+  std::vector<std::future<Value>> results;
+  for (uint64_t k = 0; k < chunks; k++) {
+    uint64_t lo = n * k / chunks, hi = n * (k + 1) / chunks;
+    results.emplace_back(council.enqueue([first, lo, hi] {
+      uint64_t step = std::max<uint64_t>(1, (hi - lo) / samplesPerChunk);
+      std::vector<Value> sample;
+      for (uint64_t i = lo; i < hi && sample.size() < samplesPerChunk;
+           i += step) {
+        sample.push_back(*(first + i));
+      }
+      std::nth_element(sample.begin(), sample.begin() + sample.size() / 2,
+                       sample.end());
+      return sample[sample.size() / 2];
+    }));
+  }
+
+  std::vector<Value> medians;
+  for (auto &&result : results) {
+    medians.push_back(result.get());
+  }
+  std::nth_element(medians.begin(), medians.begin() + medians.size() / 2,
+                   medians.end());
+  return medians[medians.size() / 2];
+}
+
+// std::partition() with `chunks` shamans. Every shaman partitions its own
+// chunk, so each chunk becomes a run of elements that pass `belongsLeft`
+// followed by a run of elements that do not. Prefix sums of the run lengths
+// give the boundary and the misplaced runs on both sides of it, and the
+// misplaced elements are then split evenly between the shamans, which swap
+// them as contiguous blocks. Every element is tested exactly once.
+//
+// Must be called from outside the council.
+template <class Iterator, class Predicate>
+Iterator parallelPartition(ThreadPool &council, uint64_t chunks,
+                           Iterator first, Iterator last,
+                           Predicate belongsLeft) {
+  // Offset and length of a run of misplaced elements.
+  typedef std::pair<uint64_t, uint64_t> Run;
+
+  uint64_t n = last - first;
+  std::vector<uint64_t> left(chunks);
+  {
+    std::vector<std::future<uint64_t>> results;
+    for (uint64_t k = 0; k < chunks; k++) {
+      Iterator lo = first + n * k / chunks, hi = first + n * (k + 1) / chunks;
+      results.emplace_back(council.enqueue([lo, hi, belongsLeft] {
+        return static_cast<uint64_t>(std::partition(lo, hi, belongsLeft) - lo);
+      }));
+    }
+    for (uint64_t k = 0; k < chunks; k++) {
+      left[k] = results[k].get();
+    }
+  }
+
+  uint64_t boundary = 0;
+  for (uint64_t k = 0; k < chunks; k++) {
+    boundary += left[k];
+  }
+  // Right elements below the boundary and left elements above it, in order.
+  std::vector<Run> wrongLeft, wrongRight;
+  uint64_t misplaced = 0;
+  for (uint64_t k = 0; k < chunks; k++) {
+    uint64_t lo = n * k / chunks, mid = lo + left[k], hi = n * (k + 1) / chunks;
+    if (mid < boundary && mid < hi) {
+      wrongLeft.push_back(Run(mid, std::min(hi, boundary) - mid));
+      misplaced += wrongLeft.back().second;
+    }
+    if (boundary < mid && lo < mid) {
+      uint64_t from = std::max(lo, boundary);
+      wrongRight.push_back(Run(from, mid - from));
+    }
+  }
+
+  std::vector<std::future<void>> results;
+  for (uint64_t k = 0; k < chunks; k++) {
+    uint64_t begin = misplaced * k / chunks;
+    uint64_t end = misplaced * (k + 1) / chunks;
+    if (begin == end) {
+      continue;
+    }
+    results.emplace_back(
+        council.enqueue([first, begin, end, &wrongLeft, &wrongRight] {
+          size_t a = 0, b = 0;
+          uint64_t inA = begin, inB = begin;
+          while (inA >= wrongLeft[a].second) {
+            inA -= wrongLeft[a++].second;
+          }
+          while (inB >= wrongRight[b].second) {
+            inB -= wrongRight[b++].second;
+          }
+          for (uint64_t count = end - begin; count > 0;) {
+            uint64_t step = std::min({count, wrongLeft[a].second - inA,
+                                      wrongRight[b].second - inB});
+            Iterator from = first + (wrongLeft[a].first + inA);
+            std::swap_ranges(from, from + step,
+                             first + (wrongRight[b].first + inB));
+            count -= step;
+            inA += step;
+            inB += step;
+            if (inA == wrongLeft[a].second) {
+              a++;
+              inA = 0;
+            }
+            if (inB == wrongRight[b].second) {
+              b++;
+              inB = 0;
+            }
+          }
+        }));
+  }
+  for (auto &&result : results) {
+    result.get();
+  }
+  return first + boundary;
+}
+
+#endif  // SRC_PARTITION_H_
@@ -0,0 +1,228 @@
+#ifndef SRC_PREPROCESSING_H_
+#define SRC_PREPROCESSING_H_
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "knapsack.h"
+#include "merge_sort.h"
+#include "sorting.h"
+#include "types.h"
+
+// How much each preprocessing rule shrank the egg list.
+struct PreprocessReport {
+  PreprocessReport() : tooBig(0), dominated(0), grouped(0), scale(1) {}
+
+  // Eggs that do not fit in the bag on their own.
+  uint64_t tooBig;
+  // Eggs without weight, or beaten by lighter-or-equal, heavier-or-equal
+  // eggs that never fit in the bag all together with them.
+  uint64_t dominated;
+  // Items saved by packing identical eggs into groups of 1, 2, 4, ...
+  uint64_t grouped;
+  // Common divisor of egg sizes that sizes and capacity were divided by.
+  uint64_t scale;
+};
+
+// Shrinks the egg list before the expensive sweep. Every reduced item
+// remembers the eggs it stands for, so packings of reduced items expand
+// back to eggs.
+class EggPreprocessor {
+ public:
+  EggPreprocessor(ThreadPool &councilArg, uint64_t numberOfShamansArg)
+      : council(councilArg), numberOfShamans(numberOfShamansArg) {}
+
+  // readItems() with the Egg::getWeight() calls split between the shamans.
+  std::vector<PackItem> readItems(std::vector<Egg> &eggs) {
+    std::vector<PackItem> items(eggs.size());
+    forChunks(eggs.size(), [&eggs, &items](uint64_t, uint64_t lo, uint64_t hi) {
+      for (uint64_t i = lo; i < hi; i++) {
+        items[i] = {eggs[i].getSize(), eggs[i].getWeight()};
+      }
+    });
+    return items;
+  }
+
+  // Reduces `items` and divides `capacity` by the report's scale. Filtering,
+  // ordering and scaling are split between the shamans; dropping dominated
+  // eggs depends on which earlier eggs were kept and grouping only appends,
+  // so those two run on the calling thread.
+  std::vector<PackItem> reduce(std::vector<PackItem> const &items,
+                               uint64_t &capacity, PreprocessReport &report) {
+    report = PreprocessReport();
+    origins.clear();
+
+    std::vector<std::vector<RankedEgg>> fitting(chunksFor(items.size()));
+    forChunks(items.size(), [&](uint64_t c, uint64_t lo, uint64_t hi) {
+      for (uint64_t i = lo; i < hi; i++) {
+        if (items[i].size <= capacity) {
+          fitting[c].push_back({items[i].size, items[i].weight, i});
+        }
+      }
+    });
+    std::vector<RankedEgg> ranked;
+    for (auto &chunk : fitting) {
+      ranked.insert(ranked.end(), chunk.begin(), chunk.end());
+    }
+    report.tooBig = items.size() - ranked.size();
+
+    MergeSorter<RankedEgg>(council, numberOfShamans).sort(ranked, false);
+    std::vector<size_t> order;
+    for (auto &egg : ranked) {
+      order.push_back(egg.index);
+    }
+
+    std::vector<size_t> kept = dropDominated(items, order, capacity);
+    report.dominated = order.size() - kept.size();
+
+    std::vector<PackItem> reduced;
+    for (size_t first = 0, last = 0; first < kept.size(); first = last) {
+      PackItem egg = items[kept[first]];
+      while (last < kept.size() && items[kept[last]].size == egg.size &&
+             items[kept[last]].weight == egg.weight) {
+        last++;
+      }
+
+      // Identical kept eggs fit in the bag all together, but their weights
+      // may not fit in 64 bits: groups stop doubling before their size or
+      // weight would overflow, and groups of 1, 2, 4, ... followed by equal
+      // groups still add up to every count of eggs.
+      size_t maxGroup = UINT64_MAX / std::max(egg.size, egg.weight);
+      for (size_t group = 1, next = first; next < last; group *= 2) {
+        group = std::min({group, last - next, maxGroup});
+        reduced.push_back({egg.size * group, egg.weight * group});
+        origins.emplace_back(kept.begin() + next, kept.begin() + next + group);
+        next += group;
+      }
+    }
+    report.grouped = kept.size() - reduced.size();
+
+    std::vector<uint64_t> divisors(chunksFor(reduced.size()), 0);
+    forChunks(reduced.size(), [&](uint64_t c, uint64_t lo, uint64_t hi) {
+      for (uint64_t i = lo; i < hi; i++) {
+        divisors[c] = gcd(divisors[c], reduced[i].size);
+      }
+    });
+    uint64_t scale = 0;
+    for (auto divisor : divisors) {
+      scale = gcd(scale, divisor);
+    }
+    if (scale > 1) {
+      forChunks(reduced.size(), [&](uint64_t, uint64_t lo, uint64_t hi) {
+        for (uint64_t i = lo; i < hi; i++) {
+          reduced[i].size /= scale;
+        }
+      });
+      capacity /= scale;
+      report.scale = scale;
+    }
+    return reduced;
+  }
+
+  // Turns a packing of reduced items into a packing of eggs.
+  Packing expand(Packing const &reduced) const {
+    Packing packing;
+    packing.weight = reduced.weight;
+    for (auto index : reduced.chosen) {
+      packing.chosen.insert(packing.chosen.end(), origins[index].begin(),
+                            origins[index].end());
+    }
+    std::sort(packing.chosen.begin(), packing.chosen.end());
+    return packing;
+  }
+
+ private:
+  // An egg can go when the eggs dominating it never fit in the bag all
+  // together with it: any packing holding it misses one of them, and
+  // swapping the two is never worse. Only kept eggs count as dominating,
+  // which keeps the rule safe while it removes eggs. The sizes of kept
+  // eggs are summed by weight rank in a Fenwick tree.
+  static std::vector<size_t> dropDominated(std::vector<PackItem> const &items,
+                                           std::vector<size_t> const &order,
+                                           uint64_t capacity) {
+    std::vector<uint64_t> weights;
+    for (auto index : order) {
+      weights.push_back(items[index].weight);
+    }
+    std::sort(weights.begin(), weights.end(), std::greater<uint64_t>());
+    weights.erase(std::unique(weights.begin(), weights.end()), weights.end());
+
+    // tree[r] sums sizes of kept eggs whose weight rank (heaviest first) is
+    // in a range ending at r.
+    std::vector<uint64_t> tree(weights.size() + 1, 0);
+    std::vector<size_t> kept;
+    for (auto index : order) {
+      PackItem const &egg = items[index];
+      if (egg.weight == 0) {
+        continue;
+      }
+      size_t rank = std::lower_bound(weights.begin(), weights.end(),
+                                     egg.weight, std::greater<uint64_t>()) -
+                    weights.begin() + 1;
+
+      uint64_t dominating = 0;
+      for (size_t r = rank; r > 0; r -= r & (-r)) {
+        dominating = saturatingAdd(dominating, tree[r]);
+      }
+      if (dominating > capacity - egg.size) {
+        continue;
+      }
+
+      kept.push_back(index);
+      for (size_t r = rank; r < tree.size(); r += r & (-r)) {
+        tree[r] = saturatingAdd(tree[r], egg.size);
+      }
+    }
+    return kept;
+  }
+
+  // Eggs in the order dropDominated() wants: lighter-or-equal first,
+  // heavier first among equal sizes, then by index.
+  struct RankedEgg {
+    bool operator<(RankedEgg const &other) const {
+      if (size != other.size) {
+        return size < other.size;
+      }
+      if (weight != other.weight) {
+        return weight > other.weight;
+      }
+      return index < other.index;
+    }
+
+    uint64_t size;
+    uint64_t weight;
+    size_t index;
+  };
+
+  uint64_t chunksFor(uint64_t n) const {
+    return std::max<uint64_t>(1, std::min(numberOfShamans, n));
+  }
+
+  // Runs task(c, lo, hi) for chunksFor(n) even chunks of [0, n) and waits.
+  template <class Task>
+  void forChunks(uint64_t n, Task const &task) {
+    runChunks(council, n, chunksFor(n), task);
+  }
+
+  static uint64_t saturatingAdd(uint64_t a, uint64_t b) {
+    return b > UINT64_MAX - a ? UINT64_MAX : a + b;
+  }
+
+  static uint64_t gcd(uint64_t a, uint64_t b) {
+    while (b != 0) {
+      uint64_t r = a % b;
+      a = b;
+      b = r;
+    }
+    return a;
+  }
+
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+  std::vector<std::vector<size_t>> origins;
+};
+
+#endif  // SRC_PREPROCESSING_H_
@@ -0,0 +1,143 @@
+#ifndef SRC_RADIX_SORT_H_
+#define SRC_RADIX_SORT_H_
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "merge_sort.h"
+#include "sorting.h"
+#include "types.h"
+
+// Tells the sorts that elements of T are ordered by an unsigned integral
+// key, so that they can read it instead of calling operator<. Types without
+// a specialization are only sorted by comparisons.
+template <class T>
+struct SortKey : std::false_type {};
+
+template <>
+struct SortKey<GrainOfSand> : std::true_type {
+  static uint64_t of(GrainOfSand const &grain) { return grain.getSize(); }
+};
+
+template <>
+struct SortKey<Crystal> : std::true_type {
+  static uint64_t of(Crystal const &crystal) {
+    return crystal.getShininess();
+  }
+};
+
+// Parallel LSD radix sort over the SortKey of the elements, one byte per
+// pass, with no comparisons at all. Every pass counts the digits of every
+// chunk at once, prefix sums over (digit, chunk) give every chunk its place
+// for each digit, and the chunks are scattered at once into a buffer kept
+// across calls; scattering keeps the order within a chunk, so the passes
+// stay stable. Bytes in which all keys agree are skipped, which a first
+// pass over the keys finds.
+//
+// Types without a SortKey are sorted by MergeSorter instead.
+//
+// Must be called from outside the council.
+template <class T>
+class RadixSorter {
+ public:
+  RadixSorter(ThreadPool &councilArg, uint64_t numberOfShamansArg)
+      : council(councilArg),
+        numberOfShamans(numberOfShamansArg),
+        fallback(councilArg, numberOfShamansArg) {}
+
+  void sort(std::vector<T> &values) { sort(values, SortKey<T>()); }
+
+ private:
+  static const uint64_t digitBits = 8;
+  static const uint64_t digits = 1 << digitBits;
+  static const uint64_t passes = 64 / digitBits;
+
+  void sort(std::vector<T> &values, std::false_type) {
+    fallback.sort(values, false);
+  }
+
+  void sort(std::vector<T> &values, std::true_type) {
+    const uint64_t threshold = 1 << 12;
+
+    uint64_t n = values.size();
+    uint64_t chunks = std::min(numberOfShamans, n / threshold + 1);
+    std::vector<std::vector<uint64_t>> counts(
+        chunks, std::vector<uint64_t>(digits * passes, 0));
+
+    runChunks(council, n, chunks, [&](uint64_t c, uint64_t lo, uint64_t hi) {
+      uint64_t *count = counts[c].data();
+      for (uint64_t i = lo; i < hi; i++) {
+        uint64_t key = SortKey<T>::of(values[i]);
+        for (uint64_t p = 0; p < passes; p++) {
+          count[p * digits + ((key >> (p * digitBits)) & (digits - 1))]++;
+        }
+      }
+    });
+    std::vector<bool> needed(passes, false);
+    for (uint64_t p = 0; p < passes; p++) {
+      for (uint64_t d = 0; d < digits; d++) {
+        uint64_t total = 0;
+        for (uint64_t c = 0; c < chunks; c++) {
+          total += counts[c][p * digits + d];
+        }
+        if (total != 0 && total != n) {
+          needed[p] = true;
+        }
+      }
+    }
+
+    // Until the first scatter, the first pass counted the right chunks.
+    bool counted = true;
+    scratch.resize(n);
+    for (uint64_t p = 0; p < passes; p++) {
+      if (needed[p]) {
+        scatter(values, p, chunks, counts, counted);
+        values.swap(scratch);
+        counted = false;
+      }
+    }
+  }
+
+  // One stable pass over byte p of the keys from `values` to `scratch`.
+  void scatter(std::vector<T> const &values, uint64_t p, uint64_t chunks,
+               std::vector<std::vector<uint64_t>> &counts, bool counted) {
+    uint64_t n = values.size(), shift = p * digitBits;
+    if (!counted) {
+      runChunks(council, n, chunks, [&](uint64_t c, uint64_t lo, uint64_t hi) {
+        uint64_t *count = counts[c].data() + p * digits;
+        std::fill(count, count + digits, 0);
+        for (uint64_t i = lo; i < hi; i++) {
+          count[(SortKey<T>::of(values[i]) >> shift) & (digits - 1)]++;
+        }
+      });
+    }
+
+    // counts[c][p * digits + d] becomes where chunk c writes digit d.
+    uint64_t offset = 0;
+    for (uint64_t d = 0; d < digits; d++) {
+      for (uint64_t c = 0; c < chunks; c++) {
+        uint64_t count = counts[c][p * digits + d];
+        counts[c][p * digits + d] = offset;
+        offset += count;
+      }
+    }
+
+    runChunks(council, n, chunks, [&](uint64_t c, uint64_t lo, uint64_t hi) {
+      uint64_t *next = counts[c].data() + p * digits;
+      for (uint64_t i = lo; i < hi; i++) {
+        uint64_t digit = (SortKey<T>::of(values[i]) >> shift) & (digits - 1);
+        scratch[next[digit]++] = values[i];
+      }
+    });
+  }
+
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+  MergeSorter<T> fallback;
+  std::vector<T> scratch;
+};
+
+#endif  // SRC_RADIX_SORT_H_
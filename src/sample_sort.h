@@ -0,0 +1,127 @@
+#ifndef SRC_SAMPLE_SORT_H_
+#define SRC_SAMPLE_SORT_H_
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "sorting.h"
+
+// Parallel sample sort. Splitters are picked from a sorted random sample
+// of `oversampling` elements per bucket, so buckets come out close to even.
+// Every shaman classifies a chunk of the input in one pass, counting
+// bucket sizes as it goes; prefix sums of the counts give every (bucket,
+// chunk) pair its place in one output buffer, the chunks are scattered
+// there at once, and the buckets are sorted independently.
+//
+// Buckets are the leaves of a complete binary search tree of splitters
+// stored level by level, so finding the bucket of an element takes log2
+// of the bucket count comparisons and no branches that depend on them. An
+// element equal to a splitter goes to the bucket on its left, so all
+// elements equal to one key share a bucket: with few distinct keys most
+// buckets stay empty and a few large ones are sorted by one shaman each.
+//
+// Must be called from outside the council.
+template <class T>
+class SampleSorter {
+ public:
+  SampleSorter(ThreadPool &councilArg, uint64_t numberOfShamansArg)
+      : council(councilArg), numberOfShamans(numberOfShamansArg) {}
+
+  void sort(std::vector<T> &values) {
+    const uint64_t threshold = 1 << 12;
+    const uint64_t bucketsPerShaman = 4;
+    const uint64_t oversampling = 16;
+
+    uint64_t n = values.size();
+    if (numberOfShamans <= 1 || n < threshold) {
+      std::sort(values.begin(), values.end());
+      return;
+    }
+    uint64_t levels = 1, buckets = 2;
+    while (buckets < bucketsPerShaman * numberOfShamans) {
+      levels++;
+      buckets *= 2;
+    }
+
+    std::vector<T> sample;
+    std::minstd_rand random(static_cast<uint32_t>(n));
+    for (uint64_t i = 0; i < oversampling * buckets; i++) {
+      sample.push_back(values[random() % n]);
+    }
+    std::sort(sample.begin(), sample.end());
+    // tree[1] is the median splitter, tree[j] has children 2j and 2j + 1.
+    std::vector<T> tree(buckets);
+    fillTree(sample, tree, 1, 0, buckets);
+
+    uint64_t chunks = numberOfShamans;
+    std::vector<uint32_t> bucketOf(n);
+    std::vector<std::vector<uint64_t>> counts(
+        chunks, std::vector<uint64_t>(buckets, 0));
+    runChunks(council, n, chunks, [&](uint64_t c, uint64_t lo, uint64_t hi) {
+      std::vector<uint64_t> &count = counts[c];
+      for (uint64_t i = lo; i < hi; i++) {
+        uint64_t j = 1;
+        for (uint64_t l = 0; l < levels; l++) {
+          j = 2 * j + static_cast<uint64_t>(tree[j] < values[i]);
+        }
+        bucketOf[i] = static_cast<uint32_t>(j - buckets);
+        count[j - buckets]++;
+      }
+    });
+
+    // counts[c][b] becomes where chunk c starts writing bucket b.
+    std::vector<uint64_t> bucketStart(buckets + 1);
+    uint64_t offset = 0;
+    for (uint64_t b = 0; b < buckets; b++) {
+      bucketStart[b] = offset;
+      for (uint64_t c = 0; c < chunks; c++) {
+        uint64_t count = counts[c][b];
+        counts[c][b] = offset;
+        offset += count;
+      }
+    }
+    bucketStart[buckets] = n;
+
+    scratch.resize(n);
+    runChunks(council, n, chunks, [&](uint64_t c, uint64_t lo, uint64_t hi) {
+      std::vector<uint64_t> &next = counts[c];
+      for (uint64_t i = lo; i < hi; i++) {
+        scratch[next[bucketOf[i]]++] = values[i];
+      }
+    });
+
+    std::vector<std::future<void>> results;
+    for (uint64_t b = 0; b < buckets; b++) {
+      auto first = scratch.begin() + bucketStart[b];
+      auto last = scratch.begin() + bucketStart[b + 1];
+      results.emplace_back(
+          council.enqueue([first, last] { std::sort(first, last); }));
+    }
+    for (auto &&result : results) {
+      result.get();
+    }
+    values.swap(scratch);
+  }
+
+ private:
+  // Splitters between buckets [lo, hi) go under node j.
+  static void fillTree(std::vector<T> const &sample, std::vector<T> &tree,
+                       uint64_t j, uint64_t lo, uint64_t hi) {
+    if (hi - lo < 2) {
+      return;
+    }
+    uint64_t mid = lo + (hi - lo) / 2;
+    tree[j] = sample[sample.size() * mid / tree.size()];
+    fillTree(sample, tree, 2 * j, lo, mid);
+    fillTree(sample, tree, 2 * j + 1, mid, hi);
+  }
+
+  ThreadPool &council;
+  uint64_t numberOfShamans;
+  std::vector<T> scratch;
+};
+
+#endif  // SRC_SAMPLE_SORT_H_
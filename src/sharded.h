@@ -0,0 +1,392 @@
+#ifndef SRC_SHARDED_H_
+#define SRC_SHARDED_H_
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "knapsack.h"
+
+// One-way channel that carries halo cells from a shard to the shard above
+// it. Both ends must stay usable across fork(). Shards run in children
+// forked while other threads may hold locks, so everything a shard calls
+// must be async-signal-safe: send() and receive() report a peer that is
+// gone by returning false, and never allocate or throw.
+class HaloLink {
+ public:
+  virtual ~HaloLink() = default;
+
+  virtual bool send(const void *data, size_t bytes) = 0;
+  virtual bool receive(void *data, size_t bytes) = 0;
+
+  // Called in every process after the fork with the directions it uses on
+  // this link. Ends it does not use are released, so that the peer of a
+  // dead process notices instead of waiting for the end it still holds.
+  virtual void keepEnds(bool sending, bool receiving) = 0;
+};
+
+typedef std::function<std::unique_ptr<HaloLink>()> HaloLinkFactory;
+
+// Ring buffer in an anonymous shared mapping, for shards on one host. One
+// process sends and one receives; both spin while the ring is full or
+// empty. A shared mapping has no ends to release, so a process stuck on a
+// dead peer waits until ShardedSweeper kills it.
+class SharedMemoryLink : public HaloLink {
+ public:
+  explicit SharedMemoryLink(size_t capacityArg) : capacity(capacityArg) {
+    void *memory = mmap(nullptr, sizeof(Ring) + capacity,
+                        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1,
+                        0);
+    if (memory == MAP_FAILED) {
+      throw std::runtime_error("cannot map shared halo memory");
+    }
+    ring = new (memory) Ring();
+  }
+
+  ~SharedMemoryLink() {
+    ring->~Ring();
+    munmap(ring, sizeof(Ring) + capacity);
+  }
+
+  SharedMemoryLink(SharedMemoryLink const &) = delete;
+  SharedMemoryLink &operator=(SharedMemoryLink const &) = delete;
+
+  virtual bool send(const void *data, size_t bytes) {
+    const char *from = static_cast<const char *>(data);
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    while (bytes > 0) {
+      uint64_t room =
+          capacity - (head - ring->tail.load(std::memory_order_acquire));
+      if (room == 0) {
+        std::this_thread::yield();
+        continue;
+      }
+      size_t count = std::min<uint64_t>(
+          {bytes, room, capacity - head % capacity});
+      std::memcpy(cells() + head % capacity, from, count);
+      head += count;
+      ring->head.store(head, std::memory_order_release);
+      from += count;
+      bytes -= count;
+    }
+    return true;
+  }
+
+  virtual bool receive(void *data, size_t bytes) {
+    char *to = static_cast<char *>(data);
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    while (bytes > 0) {
+      uint64_t ready = ring->head.load(std::memory_order_acquire) - tail;
+      if (ready == 0) {
+        std::this_thread::yield();
+        continue;
+      }
+      size_t count = std::min<uint64_t>(
+          {bytes, ready, capacity - tail % capacity});
+      std::memcpy(to, cells() + tail % capacity, count);
+      tail += count;
+      ring->tail.store(tail, std::memory_order_release);
+      to += count;
+      bytes -= count;
+    }
+    return true;
+  }
+
+  virtual void keepEnds(bool, bool) {}
+
+ private:
+  // Bytes ever sent and received; the ring holds head - tail of them.
+  struct Ring {
+    Ring() : head(0), tail(0) {}
+
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+  };
+
+  char *cells() { return reinterpret_cast<char *>(ring + 1); }
+
+  size_t capacity;
+  Ring *ring;
+};
+
+// Blocking stream socket. socketLink() makes one end-to-end on this host;
+// shards on other hosts are linked by handing over connected TCP sockets.
+class SocketLink : public HaloLink {
+ public:
+  SocketLink(int readFdArg, int writeFdArg)
+      : readFd(readFdArg), writeFd(writeFdArg) {}
+
+  ~SocketLink() { keepEnds(false, false); }
+
+  SocketLink(SocketLink const &) = delete;
+  SocketLink &operator=(SocketLink const &) = delete;
+
+  // MSG_NOSIGNAL turns a closed peer into an error instead of SIGPIPE.
+  virtual bool send(const void *data, size_t bytes) {
+    const char *from = static_cast<const char *>(data);
+    while (bytes > 0) {
+      ssize_t count = ::send(writeFd, from, bytes, MSG_NOSIGNAL);
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      if (count <= 0) {
+        return false;
+      }
+      from += count;
+      bytes -= count;
+    }
+    return true;
+  }
+
+  virtual bool receive(void *data, size_t bytes) {
+    char *to = static_cast<char *>(data);
+    while (bytes > 0) {
+      ssize_t count = read(readFd, to, bytes);
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      if (count <= 0) {
+        return false;
+      }
+      to += count;
+      bytes -= count;
+    }
+    return true;
+  }
+
+  virtual void keepEnds(bool sending, bool receiving) {
+    if (!sending && writeFd >= 0) {
+      if (writeFd != readFd) {
+        close(writeFd);
+      }
+      writeFd = -1;
+    }
+    if (!receiving && readFd >= 0) {
+      if (readFd != writeFd) {
+        close(readFd);
+      }
+      readFd = -1;
+    }
+  }
+
+ private:
+  int readFd;
+  int writeFd;
+};
+
+std::unique_ptr<HaloLink> sharedMemoryLink() {
+  const size_t ringBytes = 1 << 20;
+
+  return std::unique_ptr<HaloLink>(new SharedMemoryLink(ringBytes));
+}
+
+std::unique_ptr<HaloLink> socketLink() {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    throw std::runtime_error("cannot create halo socket");
+  }
+  // Each process only uses its own direction, so one link holds both ends.
+  return std::unique_ptr<HaloLink>(new SocketLink(fds[1], fds[0]));
+}
+
+// Sweeps a row in worker processes instead of threads, one contiguous
+// stripe per shard and one forked child per shard, while the calling
+// process only watches them. Stripes keep their bounds across eggs and a
+// shard only receives, per egg, the `size` cells just below its stripe from
+// the shard below, and passes the `size` cells just below the next stripe
+// up. When the egg is bigger than a stripe, those cells are partly
+// forwarded halo. Only neighbours talk, so any HaloLink works, and every
+// shard sends before it relaxes, so shards run as a pipeline rather than in
+// lockstep.
+//
+// The row lives in a shared mapping in which every shard relaxes its own
+// stripe. Children are forked while the council's threads run, so a shard
+// keeps to async-signal-safe calls on memory set up before the fork, and
+// reports failure by its exit status. When a shard dies or fails, the
+// others are killed, since they may be waiting for it, and extend()
+// throws. Short sweeps are not worth a fork and run in place.
+template <class Cell>
+class ShardedSweeper : public RowSweeper<Cell> {
+ public:
+  explicit ShardedSweeper(uint64_t shardsArg,
+                          HaloLinkFactory makeLinkArg = sharedMemoryLink)
+      : shards(shardsArg), makeLink(makeLinkArg) {}
+
+  virtual void extend(std::vector<PackItem> const &items, size_t first,
+                      size_t last, std::vector<Cell> &row) {
+    const uint64_t threshold = 1 << 12;
+    const uint64_t minForkCells = 1 << 20;
+
+    uint64_t N = row.size();
+    uint64_t interval = std::max(N / shards + 1, threshold);
+    if (interval >= N || (last - first) * N < minForkCells) {
+      SequentialSweeper<Cell>().extend(items, first, last, row);
+      return;
+    }
+    uint64_t stripes = (N + interval - 1) / interval;
+
+    std::vector<std::unique_ptr<HaloLink>> links;
+    for (uint64_t s = 0; s + 1 < stripes; s++) {
+      links.push_back(makeLink());
+    }
+    size_t bytes = N * sizeof(Cell);
+    void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+      throw std::runtime_error("cannot map shared row");
+    }
+    Cell *shared = static_cast<Cell *>(memory);
+    std::copy(row.begin(), row.end(), shared);
+
+    // Nothing below may allocate in a child: halo buffers are sized for the
+    // widest egg, and the row kernel picks its variant here.
+    uint64_t widest = 0;
+    for (size_t i = first; i < last; i++) {
+      if (items[i].size < N) {
+        widest = std::max(widest, items[i].size);
+      }
+    }
+    std::vector<std::vector<Cell>> halos;
+    for (uint64_t s = 0; s < stripes; s++) {
+      halos.emplace_back(std::min(widest, s * interval));
+    }
+    relaxRow<Cell>(nullptr, nullptr, nullptr, 0, 0);
+
+    std::vector<pid_t> children;
+    bool failed = false;
+    for (uint64_t s = 0; s < stripes && !failed; s++) {
+      pid_t pid = fork();
+      if (pid == 0) {
+        for (uint64_t l = 0; l < links.size(); l++) {
+          links[l]->keepEnds(l == s, l + 1 == s);
+        }
+        _exit(runShard(items, first, last, shared, N, interval, s, links,
+                       halos[s].data())
+                  ? 0
+                  : 1);
+      }
+      if (pid < 0) {
+        failed = true;
+      } else {
+        children.push_back(pid);
+      }
+    }
+    for (auto &link : links) {
+      link->keepEnds(false, false);
+    }
+    failed = !reap(children, failed);
+
+    if (!failed) {
+      std::copy(shared, shared + N, row.begin());
+    }
+    munmap(memory, bytes);
+    if (failed) {
+      throw std::runtime_error("knapsack shard failed");
+    }
+  }
+
+ private:
+  // Waits for every child and tells whether all of them succeeded. Once one
+  // fails, or `failed` is already set, the rest are killed.
+  static bool reap(std::vector<pid_t> running, bool failed) {
+    const std::chrono::microseconds pollInterval(200);
+
+    while (!running.empty()) {
+      if (failed) {
+        for (pid_t pid : running) {
+          kill(pid, SIGKILL);
+        }
+      }
+      size_t c = 0;
+      int status = 0;
+      pid_t done = 0;
+      for (; c < running.size(); c++) {
+        do {
+          done = waitpid(running[c], &status, failed ? 0 : WNOHANG);
+        } while (done < 0 && errno == EINTR);
+        if (done != 0) {
+          break;
+        }
+      }
+      if (c == running.size()) {
+        std::this_thread::sleep_for(pollInterval);
+        continue;
+      }
+      if (done != running[c] || !WIFEXITED(status) ||
+          WEXITSTATUS(status) != 0) {
+        failed = true;
+      }
+      running.erase(running.begin() + c);
+    }
+    return !failed;
+  }
+
+  // Sweeps stripe s of the shared row in place with the halos it gets from
+  // below into `halo`. Runs in a forked child; false when a neighbour is
+  // gone.
+  static bool runShard(std::vector<PackItem> const &items, size_t first,
+                       size_t last, Cell *shared, uint64_t N,
+                       uint64_t interval, uint64_t s,
+                       std::vector<std::unique_ptr<HaloLink>> const &links,
+                       Cell *halo) {
+    uint64_t lo = s * interval, hi = std::min(N, lo + interval);
+    HaloLink *below = s > 0 ? links[s - 1].get() : nullptr;
+    HaloLink *above = s < links.size() ? links[s].get() : nullptr;
+    Cell *own = shared + lo;
+
+    for (size_t i = first; i < last; i++) {
+      uint64_t size = items[i].size, weight = items[i].weight;
+      if (size >= N) {
+        continue;
+      }
+      // halo[k] is cell lo - haloCells + k of the row before the egg.
+      uint64_t haloCells = std::min(size, lo);
+      if (below != nullptr &&
+          !below->receive(halo, haloCells * sizeof(Cell))) {
+        return false;
+      }
+      if (above != nullptr) {
+        uint64_t sent = std::min(size, hi);
+        uint64_t fromHalo = sent - std::min(sent, hi - lo);
+        if (!above->send(halo + haloCells - fromHalo,
+                         fromHalo * sizeof(Cell)) ||
+            !above->send(own + (hi - lo) - (sent - fromHalo),
+                         (sent - fromHalo) * sizeof(Cell))) {
+          return false;
+        }
+      }
+
+      // Cells that take from the own stripe go first and from the top down,
+      // so the in-place relaxation reads every cell before it changes.
+      uint64_t from = std::max(lo, size), split = std::min(hi, lo + size);
+      if (split < hi) {
+        relaxRow(own + (split - lo), own + (split - lo),
+                 own + (split - size - lo), hi - split, weight);
+      }
+      if (from < split) {
+        relaxRow(own + (from - lo), own + (from - lo), halo, split - from,
+                 weight);
+      }
+    }
+    return true;
+  }
+
+  uint64_t shards;
+  HaloLinkFactory makeLink;
+};
+
+#endif  // SRC_SHARDED_H_
@@ -0,0 +1,43 @@
+#ifndef SRC_SORTING_H_
+#define SRC_SORTING_H_
+
+#include <future>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+// How TeamAdventure arranges sand.
+enum class SortEngine {
+  // Parallel partitions at the top, one range per shaman below.
+  QuickSort,
+  // Sorted runs merged in parallel, every merge split by merge path.
+  MergeSort,
+  // MergeSort that keeps equal elements in their input order.
+  StableMergeSort,
+  // Every grain classified into one of a few buckets per shaman by sampled
+  // splitters in a single pass, then the buckets sorted independently.
+  SampleSort,
+  // Byte by byte over the SortKey of the grains, without comparisons.
+  RadixSort,
+  // Stable MergeSort with binary insertion leaves and galloping merges, for
+  // when comparing grains costs far more than moving them.
+  FrugalMergeSort,
+};
+
+// Runs task(c, lo, hi) on the council for `chunks` even chunks of [0, n)
+// and waits for all of them. Must be called from outside the council.
+template <class Task>
+void runChunks(ThreadPool &council, uint64_t n, uint64_t chunks,
+               Task const &task) {
+  std::vector<std::future<void>> results;
+  for (uint64_t c = 0; c < chunks; c++) {
+    uint64_t lo = n * c / chunks, hi = n * (c + 1) / chunks;
+    results.emplace_back(
+        council.enqueue([&task, c, lo, hi] { task(c, lo, hi); }));
+  }
+  for (auto &&result : results) {
+    result.get();
+  }
+}
+
+#endif  // SRC_SORTING_H_
@@ -1,4 +1,7 @@
 #include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
 
 #include "../adventure.h"
 #include "../utils.h"
@@ -7,6 +10,34 @@ void correctnessTest(std::vector<Egg> eggs, BottomlessBag bag,
                      uint64_t expectedResults, Adventure &adventure) {
   uint64_t result = adventure.packEggs(eggs, bag);
   assert_eq_msg(result, expectedResults, "Unexpected packing result");
+
+  uint64_t packedSize = 0, packedWeight = 0;
+  for (Egg egg : bag.getEggs()) {
+    packedSize += egg.getSize();
+    packedWeight += egg.getWeight();
+  }
+  assert_msg(packedSize <= bag.getCapacity(), "Packed eggs overflow the bag");
+  assert_eq_msg(packedWeight, result, "Packed eggs do not match the result");
+}
+
+void batchTest(std::vector<Egg> eggs, std::vector<BottomlessBag> bags,
+               std::vector<uint64_t> expectedResults, Adventure &adventure) {
+  std::vector<uint64_t> results = adventure.packEggsIntoBags(eggs, bags);
+  assert_eq_msg(results.size(), bags.size(), "Unexpected number of results");
+
+  for (size_t b = 0; b < bags.size(); ++b) {
+    assert_eq_msg(results[b], expectedResults[b], "Unexpected batch result");
+
+    uint64_t packedSize = 0, packedWeight = 0;
+    for (Egg egg : bags[b].getEggs()) {
+      packedSize += egg.getSize();
+      packedWeight += egg.getWeight();
+    }
+    assert_msg(packedSize <= bags[b].getCapacity(),
+               "Packed eggs overflow the bag");
+    assert_eq_msg(packedWeight, results[b],
+                  "Packed eggs do not match the result");
+  }
 }
 
 void testCase1(Adventure &adventure) {
@@ -16,6 +47,22 @@ void testCase1(Adventure &adventure) {
   }
 }
 
+// testCase1 and testCase2 in single batches.
+void testCase10(Adventure &adventure) {
+  std::vector<BottomlessBag> bags1;
+  std::vector<uint64_t> results1;
+  for (int i = 0; i < 10; ++i) {
+    bags1.push_back(BottomlessBag(i));
+    results1.push_back(std::min(i, 6));
+  }
+  batchTest({Egg(1, 1), Egg(2, 2), Egg(3, 3)}, bags1, results1, adventure);
+
+  batchTest({Egg(5, 99999), Egg(1, 1), Egg(2, 2), Egg(3, 3), Egg(1, 99999)},
+            {BottomlessBag(6), BottomlessBag(1), BottomlessBag(5),
+             BottomlessBag(3)},
+            {2 * 99999, 99999, 99999 + 4, 99999 + 2}, adventure);
+}
+
 void testCase2(Adventure &adventure) {
   std::vector<Egg> eggs2{Egg(5, 99999), Egg(1, 1), Egg(2, 2), Egg(3, 3),
                          Egg(1, 99999)};
@@ -43,6 +90,83 @@ void testCase4(Adventure &adventure) {
   correctnessTest(eggs, BottomlessBag(10000), 15050, adventure);
 }
 
+void testCase6(Adventure &adventure) {
+  std::vector<Egg> eggs{Egg(2, 1), Egg(1, 100), Egg(4, 3), Egg(4, 3)};
+  correctnessTest(eggs, BottomlessBag(2), 100, adventure);
+  correctnessTest(eggs, BottomlessBag(5), 103, adventure);
+  correctnessTest(eggs, BottomlessBag(8), 104, adventure);
+  correctnessTest(eggs, BottomlessBag(9), 106, adventure);
+  correctnessTest(eggs, BottomlessBag(11), 107, adventure);
+}
+
+// Fill the bag: every egg weighs as much as it is big.
+void testCase8(Adventure &adventure) {
+  std::vector<Egg> eggs;
+  for (int i = 0; i < 200; ++i) {
+    uint64_t size = (i * 7919) % 3001 + 1000;
+    eggs.push_back(Egg(size, size));
+  }
+
+  correctnessTest(eggs, BottomlessBag(20011), 20011, adventure);
+  correctnessTest(eggs, BottomlessBag(999), 0, adventure);
+  correctnessTest(eggs, BottomlessBag(30000), 30000, adventure);
+}
+
+// Few eggs in a bag far too big for any capacity-indexed table.
+void testCase9(Adventure &adventure) {
+  std::vector<Egg> eggs;
+  for (uint64_t i = 1; i <= 40; ++i) {
+    eggs.push_back(Egg(i * 2654435761ULL % 1000000007ULL * 1000 + i,
+                       i * 7919 % 1009 + 1));
+  }
+
+  correctnessTest(eggs, BottomlessBag(1000000000000ULL), 5032, adventure);
+  correctnessTest(eggs, BottomlessBag(5000000000000ULL), 11775, adventure);
+}
+
+// Light eggs in an enormous bag: rows indexed by weight are short.
+void testCase12(Adventure &adventure) {
+  std::vector<Egg> eggs;
+  for (uint64_t i = 1; i <= 500; ++i) {
+    eggs.push_back(
+        Egg(i * 2654435761ULL % 1000000007ULL * 1000 + i, i % 10 + 1));
+  }
+
+  correctnessTest(eggs, BottomlessBag(50000000000000ULL), 1389, adventure);
+  correctnessTest(eggs, BottomlessBag(200000000000000ULL), 2637, adventure);
+}
+
+// Eggs too heavy for 32-bit cells.
+void testCase13(Adventure &adventure) {
+  std::vector<Egg> eggs;
+  for (uint64_t i = 0; i < 20; ++i) {
+    eggs.push_back(Egg(i % 10 + 1, 1000000000000ULL * (i % 7 + 1) + i));
+  }
+
+  correctnessTest(eggs, BottomlessBag(30), 42000000000062ULL, adventure);
+  correctnessTest(eggs, BottomlessBag(75), 68000000000137ULL, adventure);
+}
+
+// Too many eggs for meet-in-the-middle in a bag too big for rows, with
+// weights close to sizes: a search tree cut by fractional bounds.
+std::vector<Egg> correlatedEggs() {
+  std::vector<Egg> eggs;
+  for (uint64_t i = 1; i <= 80; ++i) {
+    uint64_t size = i * 2654435761ULL % 1000000007ULL * 1000 + i;
+    eggs.push_back(Egg(size, size + 100000000000ULL));
+  }
+  return eggs;
+}
+
+void testCase14(Adventure &adventure) {
+  std::vector<Egg> eggs = correlatedEggs();
+
+  correctnessTest(eggs, BottomlessBag(20000000000000ULL), 25588085236263ULL,
+                  adventure);
+  correctnessTest(eggs, BottomlessBag(35000000000000ULL), 42398356019998ULL,
+                  adventure);
+}
+
 // This test may not parallelize well. Why?
 void testCase5(Adventure &adventure) {
   std::vector<Egg> eggs;
@@ -53,6 +177,329 @@ void testCase5(Adventure &adventure) {
   correctnessTest(eggs, BottomlessBag(2000), 12079, adventure);
 }
 
+// Far more eggs than capacities: shamans split the eggs, not the row.
+void testCase11(Adventure &adventure) {
+  std::vector<Egg> eggs;
+  for (int i = 0; i < 4000; ++i) {
+    eggs.push_back(Egg(i % 20 + 1, (i * 7919) % 100003));
+  }
+
+  correctnessTest(eggs, BottomlessBag(200), 11984343, adventure);
+}
+
+// Many eggs against a wide bag: the threaded engines pay per egg for
+// handing the row to the shamans.
+void testCase7(Adventure &adventure) {
+  std::vector<Egg> eggs;
+  for (int i = 0; i < 400; ++i) {
+    eggs.push_back(Egg(i % 97 + 1, (i * 7919) % 1009));
+  }
+
+  correctnessTest(eggs, BottomlessBag(10000), 168537, adventure);
+}
+
+// Oversized, dominated and duplicate eggs with sizes sharing a factor of 3.
+void preprocessingTest() {
+  std::vector<Egg> eggs{Egg(30, 5),  Egg(6, 10), Egg(6, 10), Egg(6, 10),
+                        Egg(6, 10), Egg(6, 10), Egg(9, 9),  Egg(12, 9),
+                        Egg(3, 0),  Egg(15, 40)};
+  TeamAdventure adventure(3);
+  correctnessTest(eggs, BottomlessBag(29), 60, adventure);
+
+  PreprocessReport report = adventure.getPreprocessReport();
+  assert_eq_msg(report.tooBig, 1, "Unexpected number of oversized eggs");
+  assert_eq_msg(report.dominated, 4, "Unexpected number of dominated eggs");
+  assert_eq_msg(report.grouped, 1, "Unexpected number of grouped eggs");
+  assert_eq_msg(report.scale, 3, "Unexpected size scale");
+
+  // A group of four of these eggs would wrap its weight around to 0.
+  ThreadPool council(3);
+  EggPreprocessor preprocessor(council, 3);
+  std::vector<PackItem> heavy(7, PackItem{1, 1ULL << 62});
+  uint64_t capacity = 7;
+  uint64_t groupedSize = 0;
+  for (auto &item : preprocessor.reduce(heavy, capacity, report)) {
+    assert_eq_msg(item.weight >> 62, item.size, "Grouped weight overflows");
+    groupedSize += item.size;
+  }
+  assert_eq_msg(groupedSize, 7, "Grouping lost eggs");
+}
+
+// Stripes cut by balancedBound() share the work of an egg evenly, and the
+// threaded sweeps account time for every stripe.
+void loadBalanceTest() {
+  assert_eq_msg(balancedBound(1000, 0, 4, 0), 0, "Stripes must start at 0");
+  assert_eq_msg(balancedBound(1000, 0, 4, 2), 500, "Unexpected even split");
+  assert_eq_msg(balancedBound(1000, 0, 4, 4), 1000, "Stripes must end at N");
+  // 600 copied cells and 400 relaxed ones: 600 + 4 * 400 = 2200 units.
+  assert_eq_msg(balancedBound(1000, 600, 4, 1), 550, "Unexpected copy split");
+  assert_eq_msg(balancedBound(1000, 600, 4, 2), 725, "Unexpected mixed split");
+
+  std::vector<Egg> eggs;
+  for (int i = 0; i < 400; ++i) {
+    eggs.push_back(Egg(i % 97 + 1, (i * 7919) % 1009));
+  }
+  for (SweepSchedule schedule :
+       {SweepSchedule::Futures, SweepSchedule::Barrier}) {
+    TeamAdventure adventure(3, PackingEngine::RollingRows, schedule);
+    correctnessTest(eggs, BottomlessBag(10000), 168537, adventure);
+
+    SweepLoad load = adventure.getSweepLoad();
+    assert_eq_msg(load.busyNanos.size(), 3, "Expected a stripe per shaman");
+    assert_eq_msg(load.idleNanos.size(), 3, "Expected a stripe per shaman");
+  }
+}
+
+// Taken bits and cells of the vector kernels agree with the scalar one for
+// every count up to a word, with values on both sides of the sign bit.
+template <class Cell>
+void relaxTakenTest() {
+  const Cell top = std::numeric_limits<Cell>::max();
+
+  std::vector<Cell> keep(64), take(64), expected(64), got(64);
+  for (uint64_t i = 0; i < 64; ++i) {
+    keep[i] = static_cast<Cell>(i * 2654435761ULL);
+    take[i] = static_cast<Cell>(i * 40503ULL) / 2 + top / 4;
+  }
+  for (uint64_t count = 0; count <= 64; ++count) {
+    uint64_t bits = relaxTakenScalar(expected.data(), keep.data(),
+                                     take.data(), count, Cell(top / 8));
+    assert_eq_msg(relaxTaken(got.data(), keep.data(), take.data(), count,
+                             top / 8),
+                  bits, "Unexpected taken bits");
+    assert_msg(std::equal(got.begin(), got.begin() + count, expected.begin()),
+               "Unexpected cells");
+#ifdef SHAMANS_X86_KERNELS
+    if (__builtin_cpu_supports("avx2")) {
+      assert_eq_msg(relaxTakenAvx2(got.data(), keep.data(), take.data(), count,
+                                   Cell(top / 8)),
+                    bits, "Unexpected AVX2 taken bits");
+      assert_msg(
+          std::equal(got.begin(), got.begin() + count, expected.begin()),
+          "Unexpected AVX2 cells");
+    }
+#endif
+  }
+}
+
+// NumaSweeper on a made-up machine with two nodes agrees with a plain sweep,
+// including halos that cross several stripes.
+void numaTest() {
+  std::vector<PackItem> items;
+  for (uint64_t i = 0; i < 60; ++i) {
+    items.push_back({i * 37 % 301, i * 7919 % 1009});
+  }
+
+  ThreadPool council(3);
+  NumaSweeper<uint32_t> numa(council, 3, NumaTopology({{0}, {0}}));
+  for (uint64_t N : {10, 100, 1000, 5000}) {
+    std::vector<uint32_t> expected(N), row(N);
+    SequentialSweeper<uint32_t>().sweep(items, 0, items.size(), expected);
+    numa.sweep(items, 0, 30, row);
+    numa.extend(items, 30, items.size(), row);
+    assert_msg(row == expected, "NUMA sweep disagrees with a plain sweep");
+  }
+}
+
+// Link whose receiving shard dies on its tenth halo.
+class DyingLink : public HaloLink {
+ public:
+  explicit DyingLink(std::unique_ptr<HaloLink> linkArg)
+      : link(std::move(linkArg)), received(0) {}
+
+  virtual bool send(const void *data, size_t bytes) {
+    return link->send(data, bytes);
+  }
+
+  virtual bool receive(void *data, size_t bytes) {
+    if (++received == 10) {
+      kill(getpid(), SIGKILL);
+    }
+    return link->receive(data, bytes);
+  }
+
+  virtual void keepEnds(bool sending, bool receiving) {
+    link->keepEnds(sending, receiving);
+  }
+
+ private:
+  std::unique_ptr<HaloLink> link;
+  int received;
+};
+
+// Eggs both smaller and bigger than a stripe, so halos are also forwarded.
+void shardedTest() {
+  std::vector<PackItem> items;
+  for (uint64_t i = 0; i < 300; ++i) {
+    items.push_back({i * 7919 % 12007 + 1, i * 31 % 1009 + 1});
+  }
+
+  for (HaloLinkFactory makeLink : {sharedMemoryLink, socketLink}) {
+    ShardedSweeper<uint64_t> sharded(4, makeLink);
+    std::vector<uint64_t> expected(20000), row(20000);
+    SequentialSweeper<uint64_t>().sweep(items, 0, items.size(), expected);
+    sharded.sweep(items, 0, 150, row);
+    sharded.extend(items, 150, items.size(), row);
+    assert_msg(row == expected, "Sharded sweep disagrees with a plain sweep");
+
+    ShardedSweeper<uint64_t> dying(4, [makeLink] {
+      return std::unique_ptr<HaloLink>(new DyingLink(makeLink()));
+    });
+    bool failed = false;
+    try {
+      dying.sweep(items, 0, items.size(), row);
+    } catch (std::runtime_error const &) {
+      failed = true;
+    }
+    assert_msg(failed, "A dead shard must fail the sweep");
+  }
+
+  std::vector<Egg> eggs;
+  for (PackItem item : items) {
+    eggs.push_back(Egg(item.size, item.weight));
+  }
+  TeamAdventure oracle(3);
+  TeamAdventure processes(4, PackingEngine::RollingRows,
+                          SweepSchedule::Processes);
+  BottomlessBag bag(30000), shardedBag(30000);
+  assert_eq_msg(processes.packEggs(eggs, shardedBag),
+                oracle.packEggs(eggs, bag),
+                "Sharded packing disagrees with a single process");
+}
+
+// Egg sizes whose sum wraps around 64 bits: only one egg fits.
+void frontierOverflowTest() {
+  std::vector<PackItem> items;
+  for (uint64_t i = 1; i <= 3; ++i) {
+    items.push_back({1ULL << 63, i});
+  }
+  Packing packing = FrontierPacker(nullptr).pack(items, UINT64_MAX);
+  assert_eq_msg(packing.weight, 3, "Frontier packing overflows the bag");
+  assert_eq_msg(packing.chosen.size(), 1, "Frontier packed too many eggs");
+}
+
+// Eggs whose sizes add up past UINT64_MAX must not all go in one bag when
+// the weight-indexed DP packs them.
+void weightIndexedOverflowTest() {
+  std::vector<Egg> eggs = {Egg(1ULL << 63, 3), Egg((1ULL << 63) + 1, 4),
+                           Egg(5, 1)};
+  uint64_t capacity = (1ULL << 63) + 10;
+  LonesomeAdventure lonesome;
+  TeamAdventure automatic(3);
+  TeamAdventure weightIndexed(3, PackingEngine::WeightIndexed);
+  std::vector<Adventure *> adventures = {&lonesome, &automatic,
+                                         &weightIndexed};
+  for (Adventure *adventure : adventures) {
+    correctnessTest(eggs, BottomlessBag(capacity), 5, *adventure);
+  }
+}
+
+// Half subsets whose sizes add up past UINT64_MAX must not fit a bag of
+// UINT64_MAX.
+void meetInTheMiddleOverflowTest() {
+  std::vector<PackItem> items = {
+      {1ULL << 63, 5}, {1ULL << 63, 6}, {1, 1}, {1, 1}};
+  ThreadPool council(3);
+  MeetInTheMiddlePacker packer(
+      council, 3,
+      [](MeetInTheMiddlePacker::Iterator first,
+         MeetInTheMiddlePacker::Iterator last) { std::sort(first, last); });
+  Packing packing = packer.pack(items, UINT64_MAX);
+  assert_eq_msg(packing.weight, 8, "Meet in the middle overflows the bag");
+  assert_eq_msg(packing.chosen.size(), 3, "Unexpected meet in the middle eggs");
+}
+
+// Sizes that add up past UINT64_MAX must not shrink the bag to their sum.
+void subsetSumOverflowTest() {
+  std::vector<Egg> eggs = {Egg(1ULL << 63, 1ULL << 63),
+                           Egg((1ULL << 63) - 1, (1ULL << 63) - 1), Egg(3, 3)};
+  LonesomeAdventure adventure;
+  correctnessTest(eggs, BottomlessBag(10), 3, adventure);
+}
+
+// Tens of thousands of eggs taken on the way down the search tree, far
+// deeper than a call stack would go.
+void deepSearchTest() {
+  std::mt19937_64 random(7);
+  std::vector<Egg> eggs;
+  uint64_t total = 0;
+  for (int i = 0; i < 100000; ++i) {
+    uint64_t size = 1 + random() % (1ULL << 40);
+    eggs.push_back(Egg(size, 1 + random() % (1ULL << 40)));
+    total += size;
+  }
+  TeamAdventure adventure(3, PackingEngine::BranchAndBound);
+  correctnessTest(eggs, BottomlessBag(total / 2), 44636817691445047ULL,
+                  adventure);
+}
+
+// testCase7 with and without time to finish the DP, and testCase14.
+void anytimeTest() {
+  std::vector<Egg> eggs;
+  for (int i = 0; i < 400; ++i) {
+    eggs.push_back(Egg(i % 97 + 1, (i * 7919) % 1009));
+  }
+  TeamAdventure adventure(3);
+
+  BottomlessBag bag(10000);
+  AnytimePacking packing =
+      adventure.packEggsWithin(eggs, bag, std::chrono::seconds(60));
+  assert_msg(packing.exact(), "Expected an exact packing in time");
+  assert_eq_msg(packing.weight, 168537, "Unexpected anytime result");
+
+  BottomlessBag rushedBag(10000);
+  packing = adventure.packEggsWithin(eggs, rushedBag,
+                                     std::chrono::nanoseconds(0));
+  assert_msg(packing.weight <= 168537, "Packing beats the optimum");
+  assert_msg(packing.upperBound >= 168537, "Bound below the optimum");
+  assert_msg(2 * packing.weight >= packing.upperBound,
+             "Greedy packing below half of the bound");
+
+  uint64_t packedSize = 0, packedWeight = 0;
+  for (Egg egg : rushedBag.getEggs()) {
+    packedSize += egg.getSize();
+    packedWeight += egg.getWeight();
+  }
+  assert_msg(packedSize <= 10000, "Packed eggs overflow the bag");
+  assert_eq_msg(packedWeight, packing.weight,
+                "Packed eggs do not match the result");
+
+  BottomlessBag hugeBag(20000000000000ULL);
+  packing = adventure.packEggsWithin(correlatedEggs(), hugeBag,
+                                     std::chrono::seconds(60));
+  assert_msg(packing.exact(), "Expected an exact packing of a huge bag");
+  assert_eq_msg(packing.weight, 25588085236263ULL,
+                "Unexpected huge bag result");
+}
+
+// testCase3 with the eggs arriving in batches, through a checkpoint.
+void packingStateTest(SweepSchedule schedule) {
+  std::vector<Egg> eggs;
+  for (int i = 0; i < 33; ++i) {
+    eggs.push_back(Egg(i, i * i + 7));
+  }
+
+  TeamAdventure adventure(3, PackingEngine::Auto, schedule);
+  std::unique_ptr<EggPackingState> state = adventure.makePackingState(100);
+  state->addEggs(std::vector<Egg>(eggs.begin(), eggs.begin() + 10));
+  state->addEggs(std::vector<Egg>(eggs.begin() + 10, eggs.begin() + 20));
+
+  std::stringstream checkpoint;
+  state->saveCheckpoint(checkpoint);
+  std::unique_ptr<EggPackingState> restored =
+      adventure.makePackingState(100);
+  restored->loadCheckpoint(checkpoint);
+  assert_eq_msg(restored->getEggCount(), 20, "Checkpoint lost eggs");
+
+  restored->addEggs(std::vector<Egg>(eggs.begin() + 20, eggs.end()));
+  assert_eq_msg(restored->bestFor(100), 2969, "Unexpected state result");
+  for (uint64_t c = 0; c <= 100; c += 7) {
+    BottomlessBag bag(c);
+    assert_eq_msg(restored->bestFor(c), adventure.packEggs(eggs, bag),
+                  "State disagrees with packEggs");
+  }
+}
+
 int main(int argc, char **argv) {
   for (std::shared_ptr<Adventure> adventure :
        std::vector<std::shared_ptr<Adventure>>{
@@ -61,12 +508,43 @@ int main(int argc, char **argv) {
            std::shared_ptr<Adventure>(new TeamAdventure(2)),
            std::shared_ptr<Adventure>(new TeamAdventure(3)),
            std::shared_ptr<Adventure>(new TeamAdventure(4)),
-           std::shared_ptr<Adventure>(new TeamAdventure(8))}) {
+           std::shared_ptr<Adventure>(new TeamAdventure(8)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, PackingEngine::Table)),
+           std::shared_ptr<Adventure>(new TeamAdventure(
+               3, PackingEngine::Table, SweepSchedule::Futures, "/tmp")),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, PackingEngine::RollingRows)),
+           std::shared_ptr<Adventure>(new TeamAdventure(
+               3, PackingEngine::RollingRows, SweepSchedule::Barrier)),
+           std::shared_ptr<Adventure>(new TeamAdventure(
+               3, PackingEngine::RollingRows, SweepSchedule::Wavefront)),
+           std::shared_ptr<Adventure>(new TeamAdventure(
+               3, PackingEngine::RollingRows, SweepSchedule::NumaLocal)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, PackingEngine::SubsetSum)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, PackingEngine::Frontier)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, PackingEngine::MeetInTheMiddle)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, PackingEngine::EggPartition)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, PackingEngine::WeightIndexed)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, PackingEngine::BranchAndBound))}) {
     if (argc == 1) {
       // runAndPrintDuration([&adventure]() {
       testCase1(*adventure);
       testCase2(*adventure);
       testCase3(*adventure);
+      testCase6(*adventure);
+      testCase9(*adventure);
+      testCase10(*adventure);
+      testCase11(*adventure);
+      testCase12(*adventure);
+      testCase13(*adventure);
+      testCase14(*adventure);
       // });
     } else {
       // runAndPrintDuration([&adventure]() {
@@ -76,7 +554,33 @@ int main(int argc, char **argv) {
       // runAndPrintDuration([&adventure]() {
       testCase5(*adventure);
       // });
+
+      // runAndPrintDuration([&adventure]() {
+      testCase7(*adventure);
+      // });
+
+      // runAndPrintDuration([&adventure]() {
+      testCase8(*adventure);
+      // });
     }
   }
+  if (argc == 1) {
+    frontierOverflowTest();
+    weightIndexedOverflowTest();
+    meetInTheMiddleOverflowTest();
+    subsetSumOverflowTest();
+    deepSearchTest();
+    preprocessingTest();
+    loadBalanceTest();
+    relaxTakenTest<uint16_t>();
+    relaxTakenTest<uint32_t>();
+    relaxTakenTest<uint64_t>();
+    numaTest();
+    shardedTest();
+    anytimeTest();
+    packingStateTest(SweepSchedule::Futures);
+    packingStateTest(SweepSchedule::Barrier);
+    packingStateTest(SweepSchedule::Wavefront);
+  }
   return 0;
 }
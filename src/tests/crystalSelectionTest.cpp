@@ -41,7 +41,9 @@ int main(int argc, char **argv) {
            std::shared_ptr<Adventure>(new TeamAdventure(2)),
            std::shared_ptr<Adventure>(new TeamAdventure(3)),
            std::shared_ptr<Adventure>(new TeamAdventure(4)),
-           std::shared_ptr<Adventure>(new TeamAdventure(8))}) {
+           std::shared_ptr<Adventure>(new TeamAdventure(8)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, CrystalSelection::Keys))}) {
     if (argc == 1) {
       //runAndPrintDuration([&adventure]() {
         testCase1(*adventure);
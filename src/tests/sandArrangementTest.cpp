@@ -29,6 +29,89 @@ void testCase1(Adventure &adventure) {
   runAndVerify(adventure, t3, r3);
 }
 
+// Grains with a tag that the order ignores, so a stable sort must keep the
+// tags of equal keys increasing.
+struct TaggedGrain {
+  bool operator<(TaggedGrain const &other) const { return key < other.key; }
+  bool operator==(TaggedGrain const &other) const {
+    return key == other.key && tag == other.tag;
+  }
+
+  int key;
+  int tag;
+};
+
+void stableMergeTest() {
+  std::vector<TaggedGrain> grains;
+  for (int i = 0; i < 5000; ++i) {
+    grains.push_back({(i * 7919) % 13, i});
+  }
+  std::vector<TaggedGrain> expected = grains;
+  std::stable_sort(expected.begin(), expected.end());
+
+  ThreadPool council(3);
+  MergeSorter<TaggedGrain>(council, 3).sort(grains, true);
+  assert_msg(grains == expected, "Merge sort is not stable");
+}
+
+// TaggedGrain has no SortKey, so the radix sort compares instead.
+void radixFallbackTest() {
+  std::vector<TaggedGrain> grains;
+  for (int i = 0; i < 5000; ++i) {
+    grains.push_back({(i * 7919) % 1013, 0});
+  }
+  std::vector<TaggedGrain> expected = grains;
+  std::sort(expected.begin(), expected.end());
+
+  ThreadPool council(3);
+  RadixSorter<TaggedGrain>(council, 3).sort(grains);
+  assert_msg(grains == expected, "Radix sort fallback is not sorted");
+}
+
+// Enough grains for SampleSorter to split them into buckets, with keys all
+// different and with only three keys, which fill only three buckets.
+void sampleSortTest() {
+  for (int keys : {1000003, 3}) {
+    std::vector<TaggedGrain> grains;
+    for (int i = 0; i < 20000; ++i) {
+      grains.push_back({(i * 7919) % keys, 0});
+    }
+    std::vector<TaggedGrain> expected = grains;
+    std::sort(expected.begin(), expected.end());
+
+    ThreadPool council(3);
+    SampleSorter<TaggedGrain>(council, 3).sort(grains);
+    assert_msg(grains == expected, "Sample sort is not sorted");
+  }
+}
+
+// The frugal sort must stay stable and compare less than the default
+// engine, the quick sort of TeamAdventure, on the same grains.
+void frugalMergeTest() {
+  std::vector<Counted<TaggedGrain>> grains;
+  for (int i = 0; i < 5000; ++i) {
+    grains.push_back(TaggedGrain{(i * 7919) % 4999, i});
+  }
+  std::vector<Counted<TaggedGrain>> expected = grains;
+  std::stable_sort(expected.begin(), expected.end());
+  std::vector<Counted<TaggedGrain>> unstable = grains;
+  Counted<TaggedGrain>::comparisons() = 0;
+  TeamAdventure(3).quick_sort(unstable.begin(), unstable.end(),
+                              unstable.size() / 3 + 1);
+  uint64_t quickComparisons = Counted<TaggedGrain>::comparisons();
+
+  ThreadPool council(3);
+  Counted<TaggedGrain>::comparisons() = 0;
+  MergeSorter<Counted<TaggedGrain>>(council, 3, true).sort(grains, true);
+  uint64_t frugalComparisons = Counted<TaggedGrain>::comparisons();
+  assert_msg(grains == expected, "Frugal merge sort is not stable");
+  assert_msg(frugalComparisons < quickComparisons,
+             "Frugal merge sort compares more than the quick sort");
+  // n log2 n, above the log2 n! a comparison sort needs.
+  assert_msg(frugalComparisons < 5000 * 12.3,
+             "Frugal merge sort compares too much");
+}
+
 int main(int argc, char **argv) {
   for (std::shared_ptr<Adventure> adventure :
        std::vector<std::shared_ptr<Adventure>>{
@@ -37,7 +120,17 @@ int main(int argc, char **argv) {
            std::shared_ptr<Adventure>(new TeamAdventure(2)),
            std::shared_ptr<Adventure>(new TeamAdventure(3)),
            std::shared_ptr<Adventure>(new TeamAdventure(4)),
-           std::shared_ptr<Adventure>(new TeamAdventure(8))}) {
+           std::shared_ptr<Adventure>(new TeamAdventure(8)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, SortEngine::MergeSort)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, SortEngine::StableMergeSort)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, SortEngine::SampleSort)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, SortEngine::RadixSort)),
+           std::shared_ptr<Adventure>(
+               new TeamAdventure(3, SortEngine::FrugalMergeSort))}) {
     if (argc == 1) {
        //runAndPrintDuration([&adventure]() {
       testCase1(*adventure);
@@ -65,5 +158,11 @@ int main(int argc, char **argv) {
        printf("\n");
     }
   }
+  if (argc == 1) {
+    stableMergeTest();
+    sampleSortTest();
+    radixFallbackTest();
+    frugalMergeTest();
+  }
   return 0;
 }
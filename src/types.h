@@ -34,6 +34,10 @@ class GrainOfSand {
 
   GrainOfSand(uint64_t sizeArg) : size(sizeArg) {}  //  NOLINT
 
+  // The key of SortKey<GrainOfSand>, for the sorts that order grains
+  // without comparing them; nothing else reads it.
+  uint64_t getSize() const { return this->size; }
+
   bool operator<(GrainOfSand const& other) const {
     burden(this->size, other.size);
     return this->size < other.size;
@@ -58,6 +62,10 @@ class Crystal {
 
   Crystal(uint64_t shininessArg) : shininess(shininessArg) {}  // NOLINT
 
+  // The key of SortKey<Crystal>, for CrystalSelection::Keys; nothing else
+  // reads it.
+  uint64_t getShininess() const { return this->shininess; }
+
   bool operator<(Crystal const& other) const {
     burden(this->shininess, other.shininess);
     return this->shininess < other.shininess;
@@ -84,6 +92,10 @@ class BottomlessBag {
 
   void addEgg(Egg const& egg) { this->eggs.push_back(egg); }
 
+  // Only read by the tests, which have no other way to check what was
+  // packed; the adventures never look inside a bag.
+  std::vector<Egg> const& getEggs() const { return this->eggs; }
+
  private:
   std::vector<Egg> eggs;
 
@@ -0,0 +1,167 @@
+#ifndef SRC_WEIGHT_INDEXED_H_
+#define SRC_WEIGHT_INDEXED_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "../third_party/threadpool/threadpool.h"
+
+#include "frontier.h"
+#include "knapsack.h"
+
+// True when weight-indexed rows for this input fit in memory.
+bool weightsFit(std::vector<PackItem> const &items) {
+  const uint64_t maxRowCells = 1ULL << 28;
+
+  return totalWeight(items, 0, items.size()) <= maxRowCells;
+}
+
+// True when a row indexed by weight is much shorter than one indexed by
+// capacity, which is the case for light eggs in an enormous bag.
+bool prefersWeights(std::vector<PackItem> const &items, uint64_t capacity) {
+  const uint64_t capacityCellsPerWeightCell = 4;
+
+  return weightsFit(items) &&
+         totalWeight(items, 0, items.size()) <
+             std::min(capacity, totalSize(items)) /
+                 capacityCellsPerWeightCell;
+}
+
+// Computes the dual knapsack row: after sweep(), row[w] is the smallest size
+// of a subset of items [first, last) weighing exactly w, or UINT64_MAX when
+// no subset does. With a council every egg is split into stripes like in
+// StripedSweeper; short rows are relaxed in place.
+class WeightSweeper {
+ public:
+  WeightSweeper(ThreadPool *councilArg, uint64_t numberOfShamansArg)
+      : council(councilArg), numberOfShamans(numberOfShamansArg) {}
+
+  void sweep(std::vector<PackItem> const &items, size_t first, size_t last,
+             std::vector<uint64_t> &row) {
+    const uint64_t threshold = 1024;
+
+    uint64_t W = row.size();
+    std::fill(row.begin(), row.end(), UINT64_MAX);
+    row[0] = 0;
+
+    uint64_t interval = std::max(W / numberOfShamans + 1, threshold);
+    if (council == nullptr || interval >= W) {
+      for (size_t i = first; i < last; i++) {
+        relax(row.data(), row.data(), 0, W, items[i]);
+      }
+      return;
+    }
+
+    std::vector<uint64_t> next(W);
+    for (size_t i = first; i < last; i++) {
+      PackItem item = items[i];
+
+      std::vector<std::future<void>> results;
+      for (uint64_t lo = 0; lo < W; lo += interval) {
+        uint64_t hi = std::min(W, lo + interval);
+        results.emplace_back(council->enqueue([lo, hi, item, &row, &next] {
+          relax(row.data(), next.data(), lo, hi, item);
+        }));
+      }
+
+      for (auto &&result : results) {
+        result.get();
+      }
+      row.swap(next);
+    }
+  }
+
+ private:
+  // Cells [lo, hi) of the row after `item`; runs from high weights to low,
+  // so `curr` and `next` may be the same row.
+  static void relax(const uint64_t *curr, uint64_t *next, uint64_t lo,
+                    uint64_t hi, PackItem item) {
+    for (uint64_t w = hi; w-- > lo;) {
+      uint64_t best = curr[w];
+      if (w >= item.weight && curr[w - item.weight] != UINT64_MAX) {
+        uint64_t size = curr[w - item.weight];
+        size = item.size > UINT64_MAX - size ? UINT64_MAX : size + item.size;
+        best = std::min(best, size);
+      }
+      next[w] = best;
+    }
+  }
+
+  ThreadPool *council;
+  uint64_t numberOfShamans;
+};
+
+// Knapsack over rows indexed by weight, in O(M * total weight) time instead
+// of O(M * capacity). Eggs are recovered like in RollingRowPacker: both
+// halves of the egg list are swept, turned into "smallest size for at least
+// w" rows, and the heaviest pair that fits tells how much room each half
+// gets.
+class WeightIndexedPacker {
+ public:
+  explicit WeightIndexedPacker(WeightSweeper &sweeperArg)
+      : sweeper(sweeperArg) {}
+
+  Packing pack(std::vector<PackItem> const &items, uint64_t capacity) {
+    Packing packing;
+    solve(items, 0, items.size(), capacity, packing);
+    std::sort(packing.chosen.begin(), packing.chosen.end());
+    return packing;
+  }
+
+ private:
+  void solve(std::vector<PackItem> const &items, size_t first, size_t last,
+             uint64_t capacity, Packing &packing) {
+    // Compared against the room left, so huge sizes cannot wrap around.
+    bool fits = true;
+    uint64_t rangeSize = 0;
+    for (size_t i = first; i < last && fits; i++) {
+      fits = items[i].size <= capacity - rangeSize;
+      rangeSize += fits ? items[i].size : 0;
+    }
+    if (last - first <= 1 || fits) {
+      for (size_t i = first; i < last; i++) {
+        if (items[i].size <= capacity && items[i].weight > 0) {
+          packing.weight += items[i].weight;
+          packing.chosen.push_back(i);
+        }
+      }
+      return;
+    }
+
+    size_t mid = first + (last - first) / 2;
+    uint64_t split = 0;
+    {
+      std::vector<uint64_t> front(totalWeight(items, first, mid) + 1);
+      std::vector<uint64_t> back(totalWeight(items, mid, last) + 1);
+      sweeper.sweep(items, first, mid, front);
+      sweeper.sweep(items, mid, last, back);
+      for (size_t w = front.size() - 1; w-- > 0;) {
+        front[w] = std::min(front[w], front[w + 1]);
+      }
+      for (size_t w = back.size() - 1; w-- > 0;) {
+        back[w] = std::min(back[w], back[w + 1]);
+      }
+
+      // Heavier front subsets leave less room, so the heaviest back
+      // subset that still fits only moves down.
+      uint64_t best = 0;
+      size_t b = back.size() - 1;
+      for (size_t f = 0; f < front.size() && front[f] <= capacity; f++) {
+        while (back[b] > capacity - front[f]) {
+          b--;
+        }
+        if (f + b > best) {
+          best = f + b;
+          split = front[f];
+        }
+      }
+    }
+
+    solve(items, first, mid, split, packing);
+    solve(items, mid, last, capacity - split, packing);
+  }
+
+  WeightSweeper &sweeper;
+};
+
+#endif  // SRC_WEIGHT_INDEXED_H_